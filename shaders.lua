@@ -9,4 +9,6 @@ local function execute(cmd)
 	end
 end
 
-execute("slangc shaders/triangle.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry fragMain -o slang.spv");
+execute("slangc shaders/triangle.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry fragMain -entry fragTransparentMain -entry fragOverdrawMain -o slang.spv");
+execute("slangc shaders/cull.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry cullMain -entry occlusionMain -o cull.spv");
+execute("slangc shaders/hiz.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry downsampleMain -o hiz.spv");
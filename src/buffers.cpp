@@ -4,13 +4,17 @@
 ///
 module;
 
+#include <array>
 #include <cstddef>
 #include <print>
+#include <stdexcept>
+#include <utility>
 
 #include <vulkan/vulkan_raii.hpp>
 
 module vulkan.buffers;
 import vulkan.device;
+import vulkan.memory;
 import vulkan.commandpool;
 import vulkan.commandbuffer;
 
@@ -20,12 +24,55 @@ namespace vulkan
 Buffer::Buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties)
 {
     vk::BufferCreateInfo bufferInfo{ .size = size, .usage = usage, .sharingMode = vk::SharingMode::eExclusive };
+
+    // Uploads may land from a dedicated transfer queue, share with it instead of transferring ownership
+    const std::array queueFamilies = { Device::graphicsIndex(), Device::transferIndex() };
+    if ((usage & vk::BufferUsageFlagBits::eTransferDst) && queueFamilies[0] != queueFamilies[1]) {
+        bufferInfo.sharingMode = vk::SharingMode::eConcurrent;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+    }
     m_buffer = vk::raii::Buffer(Device::get(), bufferInfo);
-    vk::MemoryRequirements memRequirements = m_buffer.getMemoryRequirements();
-    vk::MemoryAllocateInfo allocInfo{ .allocationSize = memRequirements.size, .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties) };
-    m_bufferMemory = vk::raii::DeviceMemory(Device::get(), allocInfo);
-    m_buffer.bindMemory(*m_bufferMemory, 0);
-    
+    m_allocation = MemoryAllocator::get().Allocate(m_buffer.getMemoryRequirements(), properties, ResourceKind::eLinear);
+    m_buffer.bindMemory(m_allocation.memory, m_allocation.offset);
+}
+
+Buffer::~Buffer()
+{
+    Release();
+}
+
+Buffer::Buffer(Buffer&& other) noexcept
+    : m_buffer(std::move(other.m_buffer))
+    , m_allocation(std::exchange(other.m_allocation, Allocation{}))
+{
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept
+{
+    if (this != &other) {
+        Release();
+        m_buffer = std::move(other.m_buffer);
+        m_allocation = std::exchange(other.m_allocation, Allocation{});
+    }
+    return *this;
+}
+
+void Buffer::Release()
+{
+    // The buffer has to go before the memory it is bound to
+    m_buffer.clear();
+    if (m_allocation) {
+        MemoryAllocator::get().Free(m_allocation);
+    }
+}
+
+void* Buffer::Map() const
+{
+    if (!m_allocation.mapped) {
+        throw std::runtime_error("Trying to map a buffer that is not host visible");
+    }
+    return m_allocation.mapped;
 }
 
 void Buffer::copyBuffer(vk::raii::Buffer& dst, vk::DeviceSize size)
@@ -38,19 +85,6 @@ void Buffer::copyBuffer(vk::raii::Buffer& dst, vk::DeviceSize size)
     );
 }
 
-uint32_t Buffer::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties)
-{
-    vk::PhysicalDeviceMemoryProperties memProperties = Device::physicalDevice().getMemoryProperties();
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("failed to find suitable memory type!");
-}
-
 ////////////////////////////////////////////////////////////////////////////////////
 /// Vertex Buffer
 ////////////////////////////////////////////////////////////////////////////////////
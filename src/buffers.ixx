@@ -7,31 +7,40 @@ module;
 #include <vulkan/vulkan_raii.hpp>
 
 export module vulkan.buffers;
+import vulkan.memory;
 
 namespace vulkan {
 
 	export class Buffer {
 public:
 	Buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
-	~Buffer() = default;
+	~Buffer();
 
 	Buffer(const Buffer&) = delete;
 	Buffer& operator=(const Buffer&) = delete;
-	Buffer(Buffer&&) = default;
-	Buffer& operator=(Buffer&&) = default;
+	// The allocation has to be handed over explicitly, a moved from buffer must not free it
+	Buffer(Buffer&& other) noexcept;
+	Buffer& operator=(Buffer&& other) noexcept;
 		
 
 	void copyBuffer(vk::raii::Buffer& dst, vk::DeviceSize size);
+
+	/// @brief Host pointer to the start of the buffer, memory is mapped for as long as the buffer lives
+	/// @note Throws if the buffer was not created host visible
+	[[nodiscard]]
+	void* Map() const;
 	
 	[[nodiscard]]
 	vk::raii::Buffer& getBuffer() { return m_buffer; }
 	[[nodiscard]]
-	vk::raii::DeviceMemory& getMemory() { return m_bufferMemory; }
+	vk::Buffer handle() const { return *m_buffer; }
+	[[nodiscard]]
+	const Allocation& getAllocation() const { return m_allocation; }
 protected:
-	vk::raii::Buffer m_buffer = nullptr;
-	vk::raii::DeviceMemory m_bufferMemory = nullptr;
+	void Release();
 
-	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
+	vk::raii::Buffer m_buffer = nullptr;
+	Allocation m_allocation;
 };
 
 	// comented this out cuz ur doing it everything on mesh.cpp
@@ -0,0 +1,489 @@
+/// @file bvh.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define TOAST_BVH_SSE 1
+#endif
+
+export module bvh;
+import thread_pool;
+
+namespace toast {
+
+/// @brief Work done by a Bvh since the last ConsumeStats, times in ns
+export struct BvhStats {
+	int64_t buildTime = 0;
+	int64_t refitTime = 0;
+	int64_t queryTime = 0;
+	uint64_t builds = 0;
+	uint64_t refits = 0;
+	uint64_t queries = 0;
+	uint64_t nodesVisited = 0;
+	uint64_t visible = 0;
+};
+
+/// @brief Bounding volume hierarchy over bounding spheres with four children per node
+/// @note Built top down with binned SAH, subtrees above a size threshold are built as pool jobs.
+/// Moving objects only refit the nodes above them, the tree shape stays until the next Build
+export class Bvh {
+public:
+	/// @brief Rebuilds the whole tree, spheres are xyz center and w radius
+	void Build(ThreadPool& pool, std::span<const glm::vec4> spheres);
+
+	/// @brief Moves an object, the nodes above it are fixed by the next Refit
+	void SetSphere(uint32_t object, const glm::vec4& sphere);
+
+	/// @brief Grows or shrinks the bounds of every node above an object moved since the last call
+	void Refit();
+
+	/// @brief Rejects whole subtrees outside the planes, subtrees fully inside skip every test below them
+	/// @return Ascending indices of the objects touching the frustum, valid until the next call
+	std::span<const uint32_t> Cull(const std::array<glm::vec4, 6>& planes);
+
+	[[nodiscard]]
+	size_t size() const { return m_spheres.size(); }
+
+	[[nodiscard]]
+	size_t nodeCount() const { return m_nodeCount; }
+
+	BvhStats ConsumeStats() { return std::exchange(m_stats, {}); }
+
+private:
+	static constexpr uint32_t EMPTY = ~0u;
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+	static constexpr uint32_t BIN_COUNT = 16;
+	static constexpr uint32_t PARALLEL_THRESHOLD = 8192; // objects below which a subtree is built inline
+
+	struct Aabb {
+		float min[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+		float max[3] = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+
+		void Grow(const Aabb& other);
+		void Grow(const float point[3]);
+		[[nodiscard]]
+		float Area() const;
+	};
+
+	/// Child bounds as arrays so one register tests all four children against a plane
+	struct alignas(64) Node {
+		float minX[4], minY[4], minZ[4];
+		float maxX[4], maxY[4], maxZ[4];
+		uint32_t child[4]; // node index, first object of a leaf or EMPTY
+		uint32_t count[4]; // objects in a leaf, 0 for inner children
+
+		void SetBounds(int slot, const Aabb& bounds);
+		[[nodiscard]]
+		Aabb Bounds() const;
+	};
+
+	struct Range {
+		uint32_t first;
+		uint32_t count;
+	};
+
+	struct BuildRange {
+		uint32_t first;
+		uint32_t count;
+		Aabb bounds;
+	};
+
+	void BuildNode(TaskGroup& group, uint32_t node, uint32_t first, uint32_t count);
+	uint32_t Split(uint32_t first, uint32_t count);
+	Aabb RangeBounds(uint32_t first, uint32_t count) const;
+	Aabb ObjectBounds(uint32_t object) const;
+
+	/// @brief Bit i of outside is set when child i is outside a plane, of inside when it is inside every plane
+	static void Classify(const Node& node, const std::array<glm::vec4, 6>& planes, uint32_t& outside, uint32_t& inside);
+	bool SphereVisible(uint32_t object, const std::array<glm::vec4, 6>& planes) const;
+	void MarkVisible(uint32_t first, uint32_t count);
+
+	std::vector<glm::vec4> m_spheres;
+	std::vector<uint32_t> m_objects;     // leaves and subtrees cover contiguous ranges of it
+	std::vector<uint32_t> m_objectNodes; // node holding the leaf of every object
+	std::vector<Node> m_nodes;
+	std::vector<Range> m_nodeRanges;
+	std::vector<uint32_t> m_parents;
+	std::atomic<uint32_t> m_nextNode = 0;
+	size_t m_nodeCount = 0;
+
+	// Nodes above objects moved since the last refit
+	std::vector<uint8_t> m_refitMarks;
+	std::vector<uint32_t> m_refitNodes;
+
+	// Query scratch, visibility is gathered as bits so the result comes out sorted
+	std::vector<uint32_t> m_stack;
+	std::vector<uint64_t> m_visibleBits;
+	std::vector<uint32_t> m_visible;
+
+	BvhStats m_stats;
+};
+
+void Bvh::Aabb::Grow(const Aabb& other) {
+	for (int axis = 0; axis < 3; ++axis) {
+		min[axis] = std::min(min[axis], other.min[axis]);
+		max[axis] = std::max(max[axis], other.max[axis]);
+	}
+}
+
+void Bvh::Aabb::Grow(const float point[3]) {
+	for (int axis = 0; axis < 3; ++axis) {
+		min[axis] = std::min(min[axis], point[axis]);
+		max[axis] = std::max(max[axis], point[axis]);
+	}
+}
+
+float Bvh::Aabb::Area() const {
+	float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+	return x < 0.0f ? 0.0f : 2.0f * (x * y + y * z + z * x);
+}
+
+void Bvh::Node::SetBounds(int slot, const Aabb& bounds) {
+	minX[slot] = bounds.min[0];
+	minY[slot] = bounds.min[1];
+	minZ[slot] = bounds.min[2];
+	maxX[slot] = bounds.max[0];
+	maxY[slot] = bounds.max[1];
+	maxZ[slot] = bounds.max[2];
+}
+
+Bvh::Aabb Bvh::Node::Bounds() const {
+	Aabb bounds;
+	for (int slot = 0; slot < 4; ++slot) {
+		if (child[slot] == EMPTY) continue;
+		bounds.min[0] = std::min(bounds.min[0], minX[slot]);
+		bounds.min[1] = std::min(bounds.min[1], minY[slot]);
+		bounds.min[2] = std::min(bounds.min[2], minZ[slot]);
+		bounds.max[0] = std::max(bounds.max[0], maxX[slot]);
+		bounds.max[1] = std::max(bounds.max[1], maxY[slot]);
+		bounds.max[2] = std::max(bounds.max[2], maxZ[slot]);
+	}
+	return bounds;
+}
+
+void Bvh::Build(ThreadPool& pool, std::span<const glm::vec4> spheres) {
+	auto start = std::chrono::steady_clock::now();
+
+	uint32_t count = static_cast<uint32_t>(spheres.size());
+	m_spheres.assign(spheres.begin(), spheres.end());
+	m_objects.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		m_objects[i] = i;
+	}
+	m_objectNodes.assign(count, EMPTY);
+
+	// Every node has at least two children, so there are never more nodes than objects
+	size_t capacity = std::max<size_t>(count, 1);
+	m_nodes.resize(capacity);
+	m_nodeRanges.resize(capacity);
+	m_parents.resize(capacity);
+	m_refitMarks.assign(capacity, 0);
+	m_refitNodes.clear();
+	m_visibleBits.resize((count + 63) / 64);
+	m_visible.reserve(count);
+
+	m_nextNode.store(1, std::memory_order_relaxed);
+	m_parents[0] = EMPTY;
+	{
+		TaskGroup group(pool);
+		BuildNode(group, 0, 0, count);
+		group.Wait();
+	}
+	m_nodeCount = m_nextNode.load(std::memory_order_relaxed);
+
+	m_stats.buildTime += (std::chrono::steady_clock::now() - start).count();
+	m_stats.builds++;
+}
+
+void Bvh::BuildNode(TaskGroup& group, uint32_t node, uint32_t first, uint32_t count) {
+	// Split the widest splittable child until there are four, a binary SAH tree collapsed on the fly
+	std::array<BuildRange, 4> children;
+	children[0] = { first, count, RangeBounds(first, count) };
+	int childCount = 1;
+	while (childCount < 4) {
+		int widest = -1;
+		float widestArea = -1.0f;
+		for (int i = 0; i < childCount; ++i) {
+			float area = children[i].bounds.Area();
+			if (children[i].count > MAX_LEAF_SIZE && area > widestArea) {
+				widest = i;
+				widestArea = area;
+			}
+		}
+		if (widest < 0) {
+			break;
+		}
+
+		BuildRange range = children[widest];
+		uint32_t middle = Split(range.first, range.count);
+		uint32_t leftCount = middle - range.first, rightCount = range.first + range.count - middle;
+		children[widest] = { range.first, leftCount, RangeBounds(range.first, leftCount) };
+		children[childCount++] = { middle, rightCount, RangeBounds(middle, rightCount) };
+	}
+
+	Node& current = m_nodes[node];
+	m_nodeRanges[node] = { first, count };
+	for (int slot = 0; slot < 4; ++slot) {
+		if (slot >= childCount || children[slot].count == 0) {
+			current.SetBounds(slot, Aabb{});
+			current.child[slot] = EMPTY;
+			current.count[slot] = 0;
+			continue;
+		}
+
+		const BuildRange& range = children[slot];
+		current.SetBounds(slot, range.bounds);
+		if (range.count <= MAX_LEAF_SIZE) {
+			current.child[slot] = range.first;
+			current.count[slot] = range.count;
+			for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+				m_objectNodes[m_objects[i]] = node;
+			}
+			continue;
+		}
+
+		// Parents are allocated first, so children always have higher indices
+		uint32_t childNode = m_nextNode.fetch_add(1, std::memory_order_relaxed);
+		m_parents[childNode] = node;
+		current.child[slot] = childNode;
+		current.count[slot] = 0;
+		if (range.count > PARALLEL_THRESHOLD) {
+			group.Run([this, &group, childNode, first = range.first, count = range.count] { BuildNode(group, childNode, first, count); });
+		} else {
+			BuildNode(group, childNode, range.first, range.count);
+		}
+	}
+}
+
+uint32_t Bvh::Split(uint32_t first, uint32_t count) {
+	uint32_t end = first + count;
+	Aabb centroids;
+	for (uint32_t i = first; i < end; ++i) {
+		const glm::vec4& sphere = m_spheres[m_objects[i]];
+		float center[3] = { sphere.x, sphere.y, sphere.z };
+		centroids.Grow(center);
+	}
+
+	// Binned SAH, cost of a split is count times surface area summed over both sides
+	float bestCost = std::numeric_limits<float>::infinity();
+	int bestAxis = -1;
+	uint32_t bestBin = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		float extent = centroids.max[axis] - centroids.min[axis];
+		if (extent <= 0.0f) continue;
+		float scale = BIN_COUNT / extent;
+
+		std::array<Aabb, BIN_COUNT> bins;
+		std::array<uint32_t, BIN_COUNT> binCounts{};
+		for (uint32_t i = first; i < end; ++i) {
+			uint32_t object = m_objects[i];
+			uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((m_spheres[object][axis] - centroids.min[axis]) * scale));
+			bins[bin].Grow(ObjectBounds(object));
+			binCounts[bin]++;
+		}
+
+		std::array<float, BIN_COUNT> leftCost{};
+		Aabb left;
+		uint32_t leftCount = 0;
+		for (uint32_t bin = 0; bin + 1 < BIN_COUNT; ++bin) {
+			left.Grow(bins[bin]);
+			leftCount += binCounts[bin];
+			leftCost[bin + 1] = leftCount * left.Area();
+		}
+
+		Aabb right;
+		uint32_t rightCount = 0;
+		for (uint32_t bin = BIN_COUNT - 1; bin > 0; --bin) {
+			right.Grow(bins[bin]);
+			rightCount += binCounts[bin];
+			float cost = leftCost[bin] + rightCount * right.Area();
+			if (cost < bestCost && rightCount > 0 && rightCount < count) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+
+	// All centroids in one spot, any split is as good as another
+	if (bestAxis < 0) {
+		return first + count / 2;
+	}
+
+	float scale = BIN_COUNT / (centroids.max[bestAxis] - centroids.min[bestAxis]);
+	auto middle = std::partition(m_objects.begin() + first, m_objects.begin() + end, [&](uint32_t object) {
+		return std::min(BIN_COUNT - 1, static_cast<uint32_t>((m_spheres[object][bestAxis] - centroids.min[bestAxis]) * scale)) < bestBin;
+	});
+	return static_cast<uint32_t>(middle - m_objects.begin());
+}
+
+Bvh::Aabb Bvh::RangeBounds(uint32_t first, uint32_t count) const {
+	Aabb bounds;
+	for (uint32_t i = first; i < first + count; ++i) {
+		bounds.Grow(ObjectBounds(m_objects[i]));
+	}
+	return bounds;
+}
+
+Bvh::Aabb Bvh::ObjectBounds(uint32_t object) const {
+	const glm::vec4& sphere = m_spheres[object];
+	Aabb bounds;
+	for (int axis = 0; axis < 3; ++axis) {
+		bounds.min[axis] = sphere[axis] - sphere.w;
+		bounds.max[axis] = sphere[axis] + sphere.w;
+	}
+	return bounds;
+}
+
+void Bvh::SetSphere(uint32_t object, const glm::vec4& sphere) {
+	m_spheres[object] = sphere;
+	for (uint32_t node = m_objectNodes[object]; node != EMPTY && !m_refitMarks[node]; node = m_parents[node]) {
+		m_refitMarks[node] = 1;
+		m_refitNodes.push_back(node);
+	}
+}
+
+void Bvh::Refit() {
+	if (m_refitNodes.empty()) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	// Children have higher indices, going down the indices fixes every child before its parent
+	std::ranges::sort(m_refitNodes, std::greater{});
+	for (uint32_t index : m_refitNodes) {
+		Node& node = m_nodes[index];
+		for (int slot = 0; slot < 4; ++slot) {
+			if (node.child[slot] == EMPTY) continue;
+			node.SetBounds(slot, node.count[slot] > 0
+				? RangeBounds(node.child[slot], node.count[slot])
+				: m_nodes[node.child[slot]].Bounds());
+		}
+		m_refitMarks[index] = 0;
+	}
+	m_refitNodes.clear();
+
+	m_stats.refitTime += (std::chrono::steady_clock::now() - start).count();
+	m_stats.refits++;
+}
+
+void Bvh::Classify(const Node& node, const std::array<glm::vec4, 6>& planes, uint32_t& outside, uint32_t& inside) {
+	// Per plane, the corner farthest along the normal decides outside and the nearest one inside
+#ifdef TOAST_BVH_SSE
+	__m128 minX = _mm_load_ps(node.minX), minY = _mm_load_ps(node.minY), minZ = _mm_load_ps(node.minZ);
+	__m128 maxX = _mm_load_ps(node.maxX), maxY = _mm_load_ps(node.maxY), maxZ = _mm_load_ps(node.maxZ);
+	__m128 outsideMask = _mm_setzero_ps();
+	__m128 insideMask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	__m128 zero = _mm_setzero_ps();
+	for (const glm::vec4& plane : planes) {
+		__m128 a = _mm_set1_ps(plane.x), b = _mm_set1_ps(plane.y), c = _mm_set1_ps(plane.z), d = _mm_set1_ps(plane.w);
+		__m128 farX = plane.x >= 0.0f ? maxX : minX, nearX = plane.x >= 0.0f ? minX : maxX;
+		__m128 farY = plane.y >= 0.0f ? maxY : minY, nearY = plane.y >= 0.0f ? minY : maxY;
+		__m128 farZ = plane.z >= 0.0f ? maxZ : minZ, nearZ = plane.z >= 0.0f ? minZ : maxZ;
+		__m128 farthest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(farX, a), _mm_mul_ps(farY, b)), _mm_mul_ps(farZ, c)), d);
+		__m128 nearest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nearX, a), _mm_mul_ps(nearY, b)), _mm_mul_ps(nearZ, c)), d);
+		outsideMask = _mm_or_ps(outsideMask, _mm_cmplt_ps(farthest, zero));
+		insideMask = _mm_and_ps(insideMask, _mm_cmpge_ps(nearest, zero));
+	}
+	outside = static_cast<uint32_t>(_mm_movemask_ps(outsideMask));
+	inside = static_cast<uint32_t>(_mm_movemask_ps(insideMask));
+#else
+	outside = 0;
+	inside = 0xF;
+	for (int slot = 0; slot < 4; ++slot) {
+		for (const glm::vec4& plane : planes) {
+			float farX = plane.x >= 0.0f ? node.maxX[slot] : node.minX[slot], nearX = plane.x >= 0.0f ? node.minX[slot] : node.maxX[slot];
+			float farY = plane.y >= 0.0f ? node.maxY[slot] : node.minY[slot], nearY = plane.y >= 0.0f ? node.minY[slot] : node.maxY[slot];
+			float farZ = plane.z >= 0.0f ? node.maxZ[slot] : node.minZ[slot], nearZ = plane.z >= 0.0f ? node.minZ[slot] : node.maxZ[slot];
+			if (farX * plane.x + farY * plane.y + farZ * plane.z + plane.w < 0.0f) outside |= 1u << slot;
+			if (!(nearX * plane.x + nearY * plane.y + nearZ * plane.z + plane.w >= 0.0f)) inside &= ~(1u << slot);
+		}
+	}
+#endif
+}
+
+bool Bvh::SphereVisible(uint32_t object, const std::array<glm::vec4, 6>& planes) const {
+	const glm::vec4& sphere = m_spheres[object];
+	for (const glm::vec4& plane : planes) {
+		if (sphere.x * plane.x + sphere.y * plane.y + sphere.z * plane.z + plane.w < -sphere.w) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Bvh::MarkVisible(uint32_t first, uint32_t count) {
+	for (uint32_t i = first; i < first + count; ++i) {
+		uint32_t object = m_objects[i];
+		m_visibleBits[object / 64] |= uint64_t{1} << (object % 64);
+	}
+}
+
+std::span<const uint32_t> Bvh::Cull(const std::array<glm::vec4, 6>& planes) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::ranges::fill(m_visibleBits, 0);
+	m_visible.clear();
+	m_stack.clear();
+	if (!m_spheres.empty()) {
+		m_stack.push_back(0);
+	}
+
+	while (!m_stack.empty()) {
+		uint32_t index = m_stack.back();
+		m_stack.pop_back();
+		m_stats.nodesVisited++;
+
+		const Node& node = m_nodes[index];
+		uint32_t outside, inside;
+		Classify(node, planes, outside, inside);
+		for (int slot = 0; slot < 4; ++slot) {
+			uint32_t child = node.child[slot];
+			if (child == EMPTY || (outside >> slot) & 1) continue;
+
+			bool fullyInside = (inside >> slot) & 1;
+			if (node.count[slot] > 0) {
+				if (fullyInside) {
+					MarkVisible(child, node.count[slot]);
+				} else {
+					for (uint32_t i = child; i < child + node.count[slot]; ++i) {
+						if (SphereVisible(m_objects[i], planes)) MarkVisible(i, 1);
+					}
+				}
+			} else if (fullyInside) {
+				MarkVisible(m_nodeRanges[child].first, m_nodeRanges[child].count);
+			} else {
+				m_stack.push_back(child);
+			}
+		}
+	}
+
+	for (size_t word = 0; word < m_visibleBits.size(); ++word) {
+		for (uint64_t bits = m_visibleBits[word]; bits != 0; bits &= bits - 1) {
+			m_visible.push_back(static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+		}
+	}
+
+	m_stats.queryTime += (std::chrono::steady_clock::now() - start).count();
+	m_stats.queries++;
+	m_stats.visible += m_visible.size();
+	return m_visible;
+}
+
+}
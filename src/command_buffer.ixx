@@ -6,30 +6,45 @@ module;
 
 #include <vulkan/vulkan_raii.hpp>
 #include <functional>
+#include <mutex>
 
 export module vulkan.commandbuffer;
 import vulkan.device;
 import vulkan.swapchain;
+import vulkan.commandencoder;
 
 namespace vulkan {
 
 export class CommandBuffer {
 public:
+	CommandBuffer() = default;
 	explicit CommandBuffer(vk::raii::CommandBuffer&& buffer) 
 		: m_buffer(std::move(buffer)) {}
 
 	/// @brief Execute a recording function with automatic begin/end
+	/// @note Begin resets the buffer implicitly only if its pool allows it, buffers from frame pools are reset with the pool
 	template<typename Func>
 	void Record(Func&& recordFunc, vk::CommandBufferUsageFlags flags = {}, const vk::CommandBufferInheritanceInfo* inheritanceInfo = nullptr) {
-		m_buffer.reset();
 		m_buffer.begin(vk::CommandBufferBeginInfo{ 
 			.flags = flags,
 			.pInheritanceInfo = inheritanceInfo
 		});
+		m_encoderStats = {};
 		recordFunc(m_buffer);
 		m_buffer.end();
 	}
 
+	/// @brief Record through a CommandEncoder, state commands that change nothing never reach the driver
+	/// @note What the encoder issued and dropped stays readable through encoderStats() until the next recording
+	template<typename Func>
+	void Encode(Func&& encodeFunc, vk::CommandBufferUsageFlags flags = {}, const vk::CommandBufferInheritanceInfo* inheritanceInfo = nullptr) {
+		Record([&](vk::raii::CommandBuffer& cmdBuffer) {
+			CommandEncoder encoder(cmdBuffer);
+			encodeFunc(encoder);
+			m_encoderStats = encoder.stats();
+		}, flags, inheritanceInfo);
+	}
+
 	/// @brief Execute a one-time submit command (for transfers, etc.)
 	template<typename Func>
 	static void ExecuteImmediate(vk::raii::CommandPool& pool, Func&& func) {
@@ -48,6 +63,7 @@ public:
 			.commandBufferCount = 1,
 			.pCommandBuffers = &*cmdBuffer
 		};
+		std::lock_guard<std::mutex> lock(Device::queueMutex());
 		Device::queue().submit(submitInfo, nullptr);
 		Device::queue().waitIdle();
 	}
@@ -61,7 +77,8 @@ public:
 		vk::AccessFlags2 srcAccessMask,
 		vk::AccessFlags2 dstAccessMask,
 		vk::PipelineStageFlags2 srcStageMask,
-		vk::PipelineStageFlags2 dstStageMask
+		vk::PipelineStageFlags2 dstStageMask,
+		vk::ImageAspectFlags aspectMask = vk::ImageAspectFlagBits::eColor
 	) {
 		vk::ImageMemoryBarrier2 barrier{
 			.srcStageMask = srcStageMask,
@@ -74,7 +91,7 @@ public:
 			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
 			.image = image,
 			.subresourceRange = {
-				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.aspectMask = aspectMask,
 				.baseMipLevel = 0,
 				.levelCount = 1,
 				.baseArrayLayer = 0,
@@ -89,6 +106,28 @@ public:
 		cmdBuffer.pipelineBarrier2(dependencyInfo);
 	}
 
+	/// @brief Memory barrier over every resource, for buffers shared between passes
+	static void GlobalBarrier(
+		vk::raii::CommandBuffer& cmdBuffer,
+		vk::AccessFlags2 srcAccessMask,
+		vk::AccessFlags2 dstAccessMask,
+		vk::PipelineStageFlags2 srcStageMask,
+		vk::PipelineStageFlags2 dstStageMask
+	) {
+		vk::MemoryBarrier2 barrier{
+			.srcStageMask = srcStageMask,
+			.srcAccessMask = srcAccessMask,
+			.dstStageMask = dstStageMask,
+			.dstAccessMask = dstAccessMask
+		};
+
+		vk::DependencyInfo dependencyInfo{
+			.memoryBarrierCount = 1,
+			.pMemoryBarriers = &barrier
+		};
+		cmdBuffer.pipelineBarrier2(dependencyInfo);
+	}
+
 	/// @brief Get the underlying vulkan command buffer
 	[[nodiscard]]
 	vk::raii::CommandBuffer& get() { return m_buffer; }
@@ -96,8 +135,13 @@ public:
 	[[nodiscard]]
 	const vk::raii::CommandBuffer& get() const { return m_buffer; }
 
+	/// @brief Commands issued and elided by the last Encode, empty after a plain Record
+	[[nodiscard]]
+	const EncoderStats& encoderStats() const { return m_encoderStats; }
+
 private:
-	vk::raii::CommandBuffer m_buffer;
+	vk::raii::CommandBuffer m_buffer = nullptr;
+	EncoderStats m_encoderStats;
 };
 
 }
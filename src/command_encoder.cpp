@@ -0,0 +1,157 @@
+/// @file command_encoder.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+module vulkan.commandencoder;
+
+namespace vulkan {
+
+uint64_t EncoderStats::totalIssued() const {
+	return std::accumulate(issued.begin(), issued.end(), uint64_t{0});
+}
+
+uint64_t EncoderStats::totalElided() const {
+	return std::accumulate(elided.begin(), elided.end(), uint64_t{0});
+}
+
+CommandEncoder::BindPointState* CommandEncoder::StateOf(vk::PipelineBindPoint bindPoint) {
+	switch (bindPoint) {
+	case vk::PipelineBindPoint::eGraphics:
+		return &m_graphics;
+	case vk::PipelineBindPoint::eCompute:
+		return &m_compute;
+	default:
+		return nullptr;
+	}
+}
+
+bool CommandEncoder::Count(EncoderCommand command, bool redundant) {
+	auto index = static_cast<size_t>(command);
+	(redundant ? m_stats.elided : m_stats.issued)[index]++;
+	return !redundant;
+}
+
+void CommandEncoder::BindPipeline(vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline) {
+	BindPointState* state = StateOf(bindPoint);
+	if (!Count(EncoderCommand::ePipeline, pipeline && state && state->pipeline == pipeline)) {
+		return;
+	}
+	m_cmdBuffer.bindPipeline(bindPoint, pipeline);
+	if (state) {
+		state->pipeline = pipeline;
+	}
+}
+
+void CommandEncoder::BindDescriptorSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t firstSet,
+	vk::ArrayProxy<const vk::DescriptorSet> const& sets, vk::ArrayProxy<const uint32_t> const& dynamicOffsets) {
+	BindPointState* state = StateOf(bindPoint);
+	bool redundant = state && dynamicOffsets.empty() && layout == state->layout
+		&& firstSet + sets.size() <= MAX_TRACKED_SETS
+		&& std::all_of(sets.begin(), sets.end(), [](vk::DescriptorSet set) { return static_cast<bool>(set); })
+		&& std::equal(sets.begin(), sets.end(), state->sets.begin() + firstSet);
+	if (!Count(EncoderCommand::eDescriptorSets, redundant)) {
+		return;
+	}
+	m_cmdBuffer.bindDescriptorSets(bindPoint, layout, firstSet, sets, dynamicOffsets);
+	if (!state) {
+		return;
+	}
+
+	// Another layout may disturb every set bound before, only what this call binds is known afterwards
+	if (layout != state->layout) {
+		state->layout = layout;
+		state->sets.fill(nullptr);
+	}
+	for (uint32_t i = 0; i < sets.size() && firstSet + i < MAX_TRACKED_SETS; ++i) {
+		state->sets[firstSet + i] = dynamicOffsets.empty() ? sets.data()[i] : vk::DescriptorSet{};
+	}
+}
+
+void CommandEncoder::BindVertexBuffers(uint32_t firstBinding, vk::ArrayProxy<const vk::Buffer> const& buffers, vk::ArrayProxy<const vk::DeviceSize> const& offsets) {
+	bool tracked = firstBinding + buffers.size() <= MAX_TRACKED_VERTEX_BINDINGS;
+	bool redundant = tracked
+		&& std::all_of(buffers.begin(), buffers.end(), [](vk::Buffer buffer) { return static_cast<bool>(buffer); })
+		&& std::equal(buffers.begin(), buffers.end(), m_vertexBuffers.begin() + firstBinding)
+		&& std::equal(offsets.begin(), offsets.end(), m_vertexOffsets.begin() + firstBinding);
+	if (!Count(EncoderCommand::eVertexBuffers, redundant)) {
+		return;
+	}
+	m_cmdBuffer.bindVertexBuffers(firstBinding, buffers, offsets);
+	for (uint32_t i = 0; i < buffers.size() && firstBinding + i < MAX_TRACKED_VERTEX_BINDINGS; ++i) {
+		m_vertexBuffers[firstBinding + i] = buffers.data()[i];
+		m_vertexOffsets[firstBinding + i] = offsets.data()[i];
+	}
+}
+
+void CommandEncoder::BindIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType) {
+	bool redundant = buffer && buffer == m_indexBuffer && offset == m_indexOffset && indexType == m_indexType;
+	if (!Count(EncoderCommand::eIndexBuffer, redundant)) {
+		return;
+	}
+	m_cmdBuffer.bindIndexBuffer(buffer, offset, indexType);
+	m_indexBuffer = buffer;
+	m_indexOffset = offset;
+	m_indexType = indexType;
+}
+
+void CommandEncoder::SetViewport(const vk::Viewport& viewport) {
+	if (!Count(EncoderCommand::eViewport, m_viewport == viewport)) {
+		return;
+	}
+	m_cmdBuffer.setViewport(0, viewport);
+	m_viewport = viewport;
+}
+
+void CommandEncoder::SetScissor(const vk::Rect2D& scissor) {
+	if (!Count(EncoderCommand::eScissor, m_scissor == scissor)) {
+		return;
+	}
+	m_cmdBuffer.setScissor(0, scissor);
+	m_scissor = scissor;
+}
+
+void CommandEncoder::PushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, std::span<const std::byte> data) {
+	auto sameRange = [&](const PushConstantRange& range) { return range.stages == stages && range.offset == offset; };
+	auto known = std::ranges::find_if(m_pushConstants, sameRange);
+	bool redundant = layout == m_pushConstantLayout && known != m_pushConstants.end()
+		&& std::ranges::equal(known->data, data);
+	if (!Count(EncoderCommand::ePushConstants, redundant)) {
+		return;
+	}
+	m_cmdBuffer.pushConstants<std::byte>(layout, stages, offset, vk::ArrayProxy<const std::byte>(static_cast<uint32_t>(data.size()), data.data()));
+
+	// Ranges this one overlaps hold partly new bytes now, only the range just written is known
+	if (layout != m_pushConstantLayout) {
+		m_pushConstantLayout = layout;
+		m_pushConstants.clear();
+	}
+	uint32_t end = offset + static_cast<uint32_t>(data.size());
+	std::erase_if(m_pushConstants, [&](const PushConstantRange& range) {
+		return range.offset < end && offset < range.offset + range.data.size();
+	});
+	m_pushConstants.push_back(PushConstantRange{ .stages = stages, .offset = offset, .data = { data.begin(), data.end() } });
+}
+
+void CommandEncoder::Invalidate() {
+	m_graphics = {};
+	m_compute = {};
+	m_vertexBuffers.fill(nullptr);
+	m_vertexOffsets.fill(0);
+	m_indexBuffer = nullptr;
+	m_viewport.reset();
+	m_scissor.reset();
+	m_pushConstantLayout = nullptr;
+	m_pushConstants.clear();
+}
+
+}
@@ -0,0 +1,123 @@
+/// @file command_encoder.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+export module vulkan.commandencoder;
+
+namespace vulkan {
+
+/// @brief State setting commands a CommandEncoder tracks
+export enum class EncoderCommand : uint32_t {
+	ePipeline,
+	eDescriptorSets,
+	eVertexBuffers,
+	eIndexBuffer,
+	eViewport,
+	eScissor,
+	ePushConstants
+};
+export constexpr size_t ENCODER_COMMAND_COUNT = 7;
+
+/// @brief Commands an encoder passed to the driver and commands it dropped because they changed nothing
+export struct EncoderStats {
+	std::array<uint64_t, ENCODER_COMMAND_COUNT> issued{};
+	std::array<uint64_t, ENCODER_COMMAND_COUNT> elided{};
+
+	[[nodiscard]]
+	uint64_t totalIssued() const;
+	[[nodiscard]]
+	uint64_t totalElided() const;
+};
+
+/// @brief Records state commands into a command buffer, dropping those that set what is already bound
+/// @note Starts out knowing nothing, like a fresh command buffer. Commands recorded on get() directly are not seen,
+/// call Invalidate after any that change tracked state, e.g. executeCommands. Viewport and scissor are assumed
+/// to be dynamic state of every pipeline, binding a pipeline does not touch them
+export class CommandEncoder {
+public:
+	explicit CommandEncoder(vk::raii::CommandBuffer& cmdBuffer)
+		: m_cmdBuffer(cmdBuffer) {}
+
+	CommandEncoder(const CommandEncoder&) = delete;
+	CommandEncoder& operator=(const CommandEncoder&) = delete;
+
+	void BindPipeline(vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline);
+
+	/// @brief Sets with dynamic offsets are always bound, their offsets usually change from call to call
+	void BindDescriptorSets(vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t firstSet,
+		vk::ArrayProxy<const vk::DescriptorSet> const& sets, vk::ArrayProxy<const uint32_t> const& dynamicOffsets = nullptr);
+
+	void BindVertexBuffers(uint32_t firstBinding, vk::ArrayProxy<const vk::Buffer> const& buffers, vk::ArrayProxy<const vk::DeviceSize> const& offsets);
+	void BindIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType);
+
+	/// @brief Viewport and scissor 0, the only ones the pipelines use
+	void SetViewport(const vk::Viewport& viewport);
+	void SetScissor(const vk::Rect2D& scissor);
+
+	void PushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, std::span<const std::byte> data);
+
+	template<typename T>
+	void PushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, const T& value) {
+		PushConstants(layout, stages, offset, std::as_bytes(std::span(&value, 1)));
+	}
+
+	/// @brief Forgets everything bound, the next command of every kind reaches the driver
+	void Invalidate();
+
+	/// @brief The wrapped buffer, for draws, barriers and everything else that is not tracked
+	[[nodiscard]]
+	vk::raii::CommandBuffer& get() { return m_cmdBuffer; }
+
+	[[nodiscard]]
+	const EncoderStats& stats() const { return m_stats; }
+
+private:
+	static constexpr uint32_t MAX_TRACKED_SETS = 8;
+	static constexpr uint32_t MAX_TRACKED_VERTEX_BINDINGS = 8;
+
+	/// @brief What is bound to one pipeline bind point, null handles are unknown
+	struct BindPointState {
+		vk::Pipeline pipeline;
+		vk::PipelineLayout layout; // descriptor sets are only known for this layout
+		std::array<vk::DescriptorSet, MAX_TRACKED_SETS> sets{};
+	};
+
+	struct PushConstantRange {
+		vk::ShaderStageFlags stages;
+		uint32_t offset;
+		std::vector<std::byte> data;
+	};
+
+	/// @brief Graphics or compute, nullptr for bind points that are not tracked
+	BindPointState* StateOf(vk::PipelineBindPoint bindPoint);
+
+	/// @brief Counts the command, true if it has to be recorded
+	bool Count(EncoderCommand command, bool redundant);
+
+	vk::raii::CommandBuffer& m_cmdBuffer;
+	EncoderStats m_stats;
+
+	BindPointState m_graphics;
+	BindPointState m_compute;
+	std::array<vk::Buffer, MAX_TRACKED_VERTEX_BINDINGS> m_vertexBuffers{};
+	std::array<vk::DeviceSize, MAX_TRACKED_VERTEX_BINDINGS> m_vertexOffsets{};
+	vk::Buffer m_indexBuffer;
+	vk::DeviceSize m_indexOffset = 0;
+	vk::IndexType m_indexType = vk::IndexType::eUint32;
+	std::optional<vk::Viewport> m_viewport;
+	std::optional<vk::Rect2D> m_scissor;
+	vk::PipelineLayout m_pushConstantLayout; // ranges are only known for this layout
+	std::vector<PushConstantRange> m_pushConstants;
+};
+
+}
@@ -5,8 +5,12 @@ module;
 
 #include <print>
 #include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 module vulkan.commandpool;
 import vulkan.device;
@@ -14,12 +18,48 @@ import vulkan.commandbuffer;
 
 namespace vulkan {
 
-CommandPool::CommandPool() {
-	std::println("Creating Command Pool for thread {}...", std::this_thread::get_id());
+namespace {
 
+/// @brief One pool per frame in flight for a single thread, and its retained pool
+struct FrameRing {
+	FrameRing();
+	~FrameRing();
+
+	std::vector<std::unique_ptr<CommandPool>> pools;
+	std::unique_ptr<CommandPool> retained;
+};
+
+// Every thread's ring, so the main thread can reset a frame for all of them and free them before the device
+std::mutex g_ringsMutex;
+std::vector<FrameRing*> g_rings;
+
+std::atomic<uint64_t> g_acquiredBuffers = 0;
+std::atomic<uint64_t> g_allocatedBuffers = 0;
+
+// Buffers allocated at once when a frame pool runs out
+constexpr uint32_t BUFFER_ALLOCATION_BATCH = 8;
+
+FrameRing::FrameRing() {
+	std::lock_guard<std::mutex> lock(g_ringsMutex);
+	g_rings.push_back(this);
+}
+
+FrameRing::~FrameRing() {
+	std::lock_guard<std::mutex> lock(g_ringsMutex);
+	std::erase(g_rings, this);
+}
+
+FrameRing& CurrentRing() {
+	thread_local FrameRing t_frameRing;
+	return t_frameRing;
+}
+
+}
+
+CommandPool::CommandPool(vk::CommandPoolCreateFlags flags, uint32_t queueFamilyIndex) {
 	vk::CommandPoolCreateInfo pool_info = {
-		.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		.queueFamilyIndex = Device::graphicsIndex()
+		.flags = flags,
+		.queueFamilyIndex = queueFamilyIndex
 	};
 	m_commandPool = { Device::get(), pool_info };
 }
@@ -28,12 +68,65 @@ CommandPool& CommandPool::GetForCurrentThread() {
 	thread_local std::unique_ptr<CommandPool> t_commandPool;
 	
 	if (!t_commandPool) {
+		std::println("Creating Command Pool for thread {}...", std::this_thread::get_id());
 		t_commandPool = std::make_unique<CommandPool>();
 	}
 	
 	return *t_commandPool;
 }
 
+CommandPool& CommandPool::GetRetainedForCurrentThread() {
+	FrameRing& ring = CurrentRing();
+
+	// Any thread running a recording job may get one, the main thread too while it helps in TaskGroup::Wait
+	if (!ring.retained) {
+		std::lock_guard<std::mutex> lock(g_ringsMutex);
+		ring.retained = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+	}
+
+	return *ring.retained;
+}
+
+CommandPool& CommandPool::GetForCurrentThread(uint32_t frameIndex) {
+	FrameRing& ring = CurrentRing();
+
+	if (frameIndex >= ring.pools.size() || !ring.pools[frameIndex]) {
+		std::lock_guard<std::mutex> lock(g_ringsMutex);
+		if (frameIndex >= ring.pools.size()) {
+			ring.pools.resize(frameIndex + 1);
+		}
+		// Frame pools are only ever reset as a whole
+		std::println("Creating Command Pool for thread {} frame {}...", std::this_thread::get_id(), frameIndex);
+		ring.pools[frameIndex] = std::make_unique<CommandPool>(vk::CommandPoolCreateFlagBits::eTransient);
+	}
+
+	return *ring.pools[frameIndex];
+}
+
+void CommandPool::ResetFrame(uint32_t frameIndex) {
+	std::lock_guard<std::mutex> lock(g_ringsMutex);
+	for (FrameRing* ring : g_rings) {
+		if (frameIndex < ring->pools.size() && ring->pools[frameIndex]) {
+			ring->pools[frameIndex]->Reset();
+		}
+	}
+}
+
+void CommandPool::DestroyThreadPools() {
+	std::lock_guard<std::mutex> lock(g_ringsMutex);
+	for (FrameRing* ring : g_rings) {
+		ring->pools.clear();
+		ring->retained.reset();
+	}
+}
+
+CommandPool::Stats CommandPool::ConsumeStats() {
+	return Stats{
+		.acquired = g_acquiredBuffers.exchange(0),
+		.allocated = g_allocatedBuffers.exchange(0)
+	};
+}
+
 CommandBuffer CommandPool::AllocateBuffer(vk::CommandBufferLevel level) {
 	vk::CommandBufferAllocateInfo allocInfo{
 		.commandPool = m_commandPool,
@@ -63,4 +156,20 @@ std::vector<CommandBuffer> CommandPool::AllocateBuffers(uint32_t count, vk::Comm
 	return buffers;
 }
 
+CommandBuffer& CommandPool::AcquireBuffer(vk::CommandBufferLevel level) {
+	bool primary = level == vk::CommandBufferLevel::ePrimary;
+	auto& buffers = primary ? m_primaryBuffers : m_secondaryBuffers;
+	size_t& used = primary ? m_usedPrimary : m_usedSecondary;
+
+	g_acquiredBuffers.fetch_add(1, std::memory_order_relaxed);
+	if (used == buffers.size()) {
+		for (auto& buffer : AllocateBuffers(BUFFER_ALLOCATION_BATCH, level)) {
+			buffers.push_back(std::move(buffer));
+		}
+		g_allocatedBuffers.fetch_add(BUFFER_ALLOCATION_BATCH, std::memory_order_relaxed);
+	}
+
+	return buffers[used++];
+}
+
 }
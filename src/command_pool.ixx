@@ -5,6 +5,10 @@
 module;
 
 #include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -16,10 +20,33 @@ namespace vulkan {
 
 export class CommandPool {
 public:
-	CommandPool();
+	explicit CommandPool(vk::CommandPoolCreateFlags flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, uint32_t queueFamilyIndex = Device::graphicsIndex());
 
+	/// @brief General purpose pool of the calling thread
 	static CommandPool& GetForCurrentThread();
 
+	/// @brief Persistent pool of the calling thread for RetainedCommandBuffer, buffers are reset one by one
+	static CommandPool& GetRetainedForCurrentThread();
+
+	/// @brief Pool of the calling thread for one frame in flight
+	/// @note Its buffers stay valid until ResetFrame is called for the same frame index
+	static CommandPool& GetForCurrentThread(uint32_t frameIndex);
+
+	/// @brief Resets the pool of every thread for a frame in flight, call once the GPU finished its last frame
+	static void ResetFrame(uint32_t frameIndex);
+
+	/// @brief Destroys the frame and retained pools of every thread, the device has to be idle
+	/// @note Buffers taken from a retained pool have to be gone already
+	static void DestroyThreadPools();
+
+	struct Stats {
+		uint64_t acquired = 0;  ///< Buffers handed out by AcquireBuffer
+		uint64_t allocated = 0; ///< Of those, how many needed a new vkAllocateCommandBuffers
+	};
+
+	/// @brief Returns the frame pool counters since the last call and clears them
+	static Stats ConsumeStats();
+
 	/// @brief Allocate a single command buffer
 	[[nodiscard]]
 	CommandBuffer AllocateBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
@@ -28,18 +55,70 @@ public:
 	[[nodiscard]]
 	std::vector<CommandBuffer> AllocateBuffers(uint32_t count, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
 
+	/// @brief Hands out a buffer owned by the pool, recycled after the next Reset
+	[[nodiscard]]
+	CommandBuffer& AcquireBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
+
 	/// @brief Get the underlying pool
 	[[nodiscard]]
 	vk::raii::CommandPool& get() { return m_commandPool; }
 
-	/// @brief Reset the entire pool
+	/// @brief Reset the entire pool, every acquired buffer goes back to the free list
 	void Reset(vk::CommandPoolResetFlags flags = {}) {
 		m_commandPool.reset(flags);
+		m_usedPrimary = 0;
+		m_usedSecondary = 0;
 	}
 
 private:
 	vk::raii::CommandPool m_commandPool = nullptr;
+
+	// Deques keep handed out references stable while the pool grows
+	std::deque<CommandBuffer> m_primaryBuffers;
+	std::deque<CommandBuffer> m_secondaryBuffers;
+	size_t m_usedPrimary = 0;
+	size_t m_usedSecondary = 0;
 };
 
-}
+/// @brief Secondary buffer recorded once and replayed until what it draws changes
+/// @note Whichever thread finds it stale re-records it, into a buffer from that thread's retained pool so no
+/// pool is ever touched by two threads. It keeps one buffer per thread that recorded it, and has to be
+/// destroyed before those threads exit
+export class RetainedCommandBuffer {
+public:
+	/// @brief True if the recorded contents are from another version
+	[[nodiscard]]
+	bool IsStale(uint64_t version) const { return m_version != version; }
 
+	/// @brief Hands out the calling thread's buffer and tags it with the version about to be recorded into it
+	/// @note The buffer must not be pending execution, its pool resets it when recording begins
+	[[nodiscard]]
+	CommandBuffer& Rerecord(uint64_t version) {
+		CommandPool& pool = CommandPool::GetRetainedForCurrentThread();
+		auto it = std::ranges::find(m_buffers, &pool, &ThreadBuffer::pool);
+		if (it == m_buffers.end()) {
+			m_buffers.push_back({ &pool, pool.AllocateBuffer(vk::CommandBufferLevel::eSecondary) });
+			it = std::prev(m_buffers.end());
+		}
+		m_current = static_cast<size_t>(it - m_buffers.begin());
+		m_version = version;
+		return it->buffer;
+	}
+
+	[[nodiscard]]
+	vk::CommandBuffer handle() const { return *m_buffers[m_current].buffer.get(); }
+
+private:
+	static constexpr uint64_t NEVER_RECORDED = ~0ull;
+
+	struct ThreadBuffer {
+		CommandPool* pool = nullptr;
+		CommandBuffer buffer;
+	};
+
+	std::vector<ThreadBuffer> m_buffers;
+	size_t m_current = 0;
+	uint64_t m_version = NEVER_RECORDED;
+};
+
+}
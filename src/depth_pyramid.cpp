@@ -0,0 +1,188 @@
+/// @file depth_pyramid.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <print>
+#include <vector>
+
+module vulkan.depthpyramid;
+import vulkan.device;
+import vulkan.image;
+import vulkan.pipeline;
+import vulkan.commandbuffer;
+
+namespace vulkan {
+
+DepthPyramid::DepthPyramid(const Image& depth) {
+	vk::Extent2D extent = depth.extent();
+	uint32_t levelCount = std::bit_width(std::max(extent.width, extent.height));
+	m_pyramid = std::make_unique<Image>(
+		extent,
+		vk::Format::eR32Sfloat,
+		vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+		vk::ImageAspectFlagBits::eColor,
+		levelCount
+	);
+
+	CreatePipeline();
+	CreateDescriptorSets(depth);
+	std::println("Created depth pyramid of {}x{} with {} levels", extent.width, extent.height, levelCount);
+}
+
+void DepthPyramid::CreatePipeline() {
+	std::array bindings = {
+		vk::DescriptorSetLayoutBinding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eSampledImage,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eCompute
+		},
+		vk::DescriptorSetLayoutBinding{
+			.binding = 1,
+			.descriptorType = vk::DescriptorType::eStorageImage,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eCompute
+		}
+	};
+	m_descriptorSetLayout = vk::raii::DescriptorSetLayout(Device::get(), vk::DescriptorSetLayoutCreateInfo{
+		.bindingCount = static_cast<uint32_t>(bindings.size()),
+		.pBindings = bindings.data()
+	});
+
+	vk::PushConstantRange pushConstants{
+		.stageFlags = vk::ShaderStageFlagBits::eCompute,
+		.offset = 0,
+		.size = sizeof(DownsampleParams)
+	};
+	m_pipelineLayout = vk::raii::PipelineLayout(Device::get(), vk::PipelineLayoutCreateInfo{
+		.setLayoutCount = 1,
+		.pSetLayouts = &*m_descriptorSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushConstants
+	});
+
+	auto code = ReadFile("hiz.spv");
+	vk::raii::ShaderModule shaderModule(Device::get(), vk::ShaderModuleCreateInfo{
+		.codeSize = code.size(),
+		.pCode = reinterpret_cast<const uint32_t*>(code.data())
+	});
+
+	m_pipeline = vk::raii::Pipeline(Device::get(), nullptr, vk::ComputePipelineCreateInfo{
+		.stage = {
+			.stage = vk::ShaderStageFlagBits::eCompute,
+			.module = shaderModule,
+			.pName = "downsampleMain"
+		},
+		.layout = *m_pipelineLayout
+	});
+}
+
+void DepthPyramid::CreateDescriptorSets(const Image& depth) {
+	uint32_t levelCount = m_pyramid->mipLevels();
+	std::array poolSizes = {
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eSampledImage, .descriptorCount = levelCount },
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageImage, .descriptorCount = levelCount }
+	};
+	m_descriptorPool = vk::raii::DescriptorPool(Device::get(), vk::DescriptorPoolCreateInfo{
+		.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+		.maxSets = levelCount,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data()
+	});
+
+	std::vector<vk::DescriptorSetLayout> layouts(levelCount, *m_descriptorSetLayout);
+	m_descriptorSets = vk::raii::DescriptorSets(Device::get(), vk::DescriptorSetAllocateInfo{
+		.descriptorPool = *m_descriptorPool,
+		.descriptorSetCount = levelCount,
+		.pSetLayouts = layouts.data()
+	});
+
+	// Level 0 copies the depth buffer, every other level reads the one above it
+	for (uint32_t level = 0; level < levelCount; ++level) {
+		vk::DescriptorImageInfo sourceInfo = level == 0
+			? vk::DescriptorImageInfo{ .imageView = depth.view(), .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal }
+			: vk::DescriptorImageInfo{ .imageView = m_pyramid->mipView(level - 1), .imageLayout = vk::ImageLayout::eGeneral };
+		vk::DescriptorImageInfo destinationInfo{ .imageView = m_pyramid->mipView(level), .imageLayout = vk::ImageLayout::eGeneral };
+		std::array writes = {
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[level],
+				.dstBinding = 0,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eSampledImage,
+				.pImageInfo = &sourceInfo
+			},
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[level],
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageImage,
+				.pImageInfo = &destinationInfo
+			}
+		};
+		Device::get().updateDescriptorSets(writes, nullptr);
+	}
+}
+
+void DepthPyramid::Build(vk::raii::CommandBuffer& cmdBuffer) const {
+	// Last frame's occlusion test may still read the pyramid, its content is rebuilt from scratch
+	vk::ImageMemoryBarrier2 barrier{
+		.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+		.srcAccessMask = {},
+		.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+		.dstAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+		.oldLayout = vk::ImageLayout::eUndefined,
+		.newLayout = vk::ImageLayout::eGeneral,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = m_pyramid->handle(),
+		.subresourceRange = {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = VK_REMAINING_MIP_LEVELS,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		}
+	};
+	cmdBuffer.pipelineBarrier2(vk::DependencyInfo{
+		.imageMemoryBarrierCount = 1,
+		.pImageMemoryBarriers = &barrier
+	});
+
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+	vk::Extent2D source = m_pyramid->extent();
+	for (uint32_t level = 0; level < m_pyramid->mipLevels(); ++level) {
+		vk::Extent2D destination = level == 0 ? source
+			: vk::Extent2D{ std::max(1u, source.width / 2), std::max(1u, source.height / 2) };
+
+		DownsampleParams params{
+			.sourceWidth = source.width,
+			.sourceHeight = source.height,
+			.destinationWidth = destination.width,
+			.destinationHeight = destination.height
+		};
+		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout, 0, *m_descriptorSets[level], nullptr);
+		cmdBuffer.pushConstants<DownsampleParams>(*m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, params);
+		cmdBuffer.dispatch((destination.width + 7) / 8, (destination.height + 7) / 8, 1);
+
+		// The next level reads this one, after the last one the occlusion test does
+		CommandBuffer::GlobalBarrier(
+			cmdBuffer,
+			vk::AccessFlagBits2::eShaderStorageWrite,
+			vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageRead,
+			vk::PipelineStageFlagBits2::eComputeShader,
+			vk::PipelineStageFlagBits2::eComputeShader
+		);
+		source = destination;
+	}
+}
+
+}
@@ -0,0 +1,55 @@
+/// @file depth_pyramid.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <memory>
+
+export module vulkan.depthpyramid;
+import vulkan.image;
+
+namespace vulkan {
+
+/// @brief Hierarchical Z mip chain of a depth buffer, every texel holds the farthest depth below it
+/// @note Level 0 matches the depth buffer, each further level halves it with odd rows and columns
+/// folded into the last texel, so texel x of level l covers pixels [x << l, (x + 1) << l)
+export class DepthPyramid {
+public:
+	/// @param depth Has to be sampleable, it is read in eShaderReadOnlyOptimal
+	explicit DepthPyramid(const Image& depth);
+
+	/// @brief Records every downsample pass, depth has to be in eShaderReadOnlyOptimal
+	/// @note Leaves the pyramid in eGeneral, readable by compute shaders
+	void Build(vk::raii::CommandBuffer& cmdBuffer) const;
+
+	[[nodiscard]]
+	const Image& image() const { return *m_pyramid; }
+	[[nodiscard]]
+	vk::Extent2D extent() const { return m_pyramid->extent(); }
+	[[nodiscard]]
+	uint32_t levelCount() const { return m_pyramid->mipLevels(); }
+
+private:
+	struct DownsampleParams {
+		uint32_t sourceWidth;
+		uint32_t sourceHeight;
+		uint32_t destinationWidth;
+		uint32_t destinationHeight;
+	};
+
+	void CreatePipeline();
+	void CreateDescriptorSets(const Image& depth);
+
+	std::unique_ptr<Image> m_pyramid;
+
+	vk::raii::DescriptorSetLayout m_descriptorSetLayout = nullptr;
+	vk::raii::PipelineLayout m_pipelineLayout = nullptr;
+	vk::raii::Pipeline m_pipeline = nullptr;
+	vk::raii::DescriptorPool m_descriptorPool = nullptr;
+	vk::raii::DescriptorSets m_descriptorSets = nullptr; // one per level, reading the level above
+};
+
+}
@@ -190,6 +190,16 @@ void Device::CreateLogicalDevice() {
 
 	std::println("Got present queue at {}", present_index);
 
+	// Prefer a transfer-only family so uploads run on the copy engine next to rendering
+	auto transferQueueFamilyProperty = std::ranges::find_if(queue_properties, [](auto const& qfp) {
+		return (qfp.queueFlags & vk::QueueFlagBits::eTransfer)
+			&& !(qfp.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+	});
+	uint32_t transfer_index = transferQueueFamilyProperty != queue_properties.end()
+		? static_cast<uint32_t>(std::distance(queue_properties.begin(), transferQueueFamilyProperty))
+		: graphics_index;
+	std::println("Got transfer queue at {}{}", transfer_index, transfer_index == graphics_index ? " (shared with graphics)" : "");
+
 	// Create queue infos
 	float queue_priority = 0.5f;
 	std::vector<vk::DeviceQueueCreateInfo> queues_info;
@@ -213,6 +223,14 @@ void Device::CreateLogicalDevice() {
 		});
 	}
 
+	if (transfer_index != graphics_index && transfer_index != present_index) {
+		queues_info.push_back(vk::DeviceQueueCreateInfo{
+			.queueFamilyIndex = transfer_index,
+			.queueCount = 1,
+			.pQueuePriorities = &queue_priority
+		});
+	}
+
 	// Enable features
 	vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extDynamicState{
 		.extendedDynamicState = true
@@ -221,8 +239,13 @@ void Device::CreateLogicalDevice() {
 		.pNext = &extDynamicState,
 		.shaderDrawParameters = true
 	};
-	vk::PhysicalDeviceVulkan13Features vk13Features{
+	vk::PhysicalDeviceVulkan12Features vk12Features{
 		.pNext = &vk11Features,
+		.drawIndirectCount = true,
+		.timelineSemaphore = true
+	};
+	vk::PhysicalDeviceVulkan13Features vk13Features{
+		.pNext = &vk12Features,
 		.synchronization2 = true,
 		.dynamicRendering = true
 	};
@@ -253,8 +276,10 @@ void Device::CreateLogicalDevice() {
 	// Retrieve graphics and present queues
 	m_graphicsQueue = vk::raii::Queue(m_device, graphics_index, 0);
 	m_presentQueue = vk::raii::Queue(m_device, present_index, 0);
+	m_transferQueue = vk::raii::Queue(m_device, transfer_index, 0);
 	m_graphicsFamilyIndex = graphics_index;
 	m_presentFamilyIndex = present_index;
+	m_transferFamilyIndex = transfer_index;
 
 	std::println("Created Vulkan Device");
 }
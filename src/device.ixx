@@ -5,6 +5,7 @@
 module;
 #include <vulkan/vulkan_raii.hpp>
 #include <expected>
+#include <mutex>
 
 export module vulkan.device;
 
@@ -38,10 +39,19 @@ public:
 	[[nodiscard]] /// @brief Get present queue
 	static vk::raii::Queue& presentQueue() { return device()->m_presentQueue; }
 
+	[[nodiscard]] /// @brief Get transfer queue, the graphics queue if there is no dedicated transfer family
+	static vk::raii::Queue& transferQueue() { return device()->m_transferQueue; }
+
+	[[nodiscard]] /// @brief Lock held around every queue submit, present and wait idle
+	/// @note Graphics, present and transfer can all be the same VkQueue, so one lock covers all of them
+	static std::mutex& queueMutex() { return device()->m_queueMutex; }
+
 	[[nodiscard]]
 	static uint32_t graphicsIndex() { return device()->m_graphicsFamilyIndex; }
 	[[nodiscard]]
 	static uint32_t presentIndex() { return device()->m_presentFamilyIndex; }
+	[[nodiscard]]
+	static uint32_t transferIndex() { return device()->m_transferFamilyIndex; }
 
 private:
 	void PickPhysicalDevice();
@@ -54,8 +64,11 @@ private:
 	vk::raii::Device m_device = nullptr;
 	uint32_t m_graphicsFamilyIndex;
 	uint32_t m_presentFamilyIndex;
+	uint32_t m_transferFamilyIndex;
 	vk::raii::Queue m_graphicsQueue = nullptr;
 	vk::raii::Queue m_presentQueue = nullptr;
+	vk::raii::Queue m_transferQueue = nullptr;
+	std::mutex m_queueMutex;
 };
 
 /// @brief public wrapper to get the vulkan device
@@ -0,0 +1,138 @@
+/// @file frame_data.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <print>
+#include <vector>
+
+module vulkan.framedata;
+import vulkan.buffers;
+import vulkan.device;
+import vulkan.commandencoder;
+
+namespace vulkan {
+
+FrameData::FrameData(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount, uint32_t objectCapacity)
+	: m_objectCapacity(std::max(objectCapacity, 1u))
+{
+	vk::DeviceSize bufferSize = sizeof(ObjectData) * m_objectCapacity;
+
+	m_cameraBuffers.reserve(frameCount);
+	m_cameraMapped.reserve(frameCount);
+	m_objectBuffers.reserve(frameCount);
+	m_mapped.reserve(frameCount);
+	m_instanceBuffers.reserve(frameCount);
+	m_instancesMapped.reserve(frameCount);
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		m_cameraBuffers.push_back(std::make_unique<Buffer>(
+			sizeof(CameraData),
+			vk::BufferUsageFlagBits::eUniformBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		));
+		m_cameraMapped.push_back(static_cast<CameraData*>(m_cameraBuffers.back()->Map()));
+
+		m_objectBuffers.push_back(std::make_unique<Buffer>(
+			bufferSize,
+			vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		));
+		m_mapped.push_back(static_cast<ObjectData*>(m_objectBuffers.back()->Map()));
+
+		m_instanceBuffers.push_back(std::make_unique<Buffer>(
+			sizeof(uint32_t) * m_objectCapacity,
+			vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		));
+		m_instancesMapped.push_back(static_cast<uint32_t*>(m_instanceBuffers.back()->Map()));
+	}
+
+	CreateDescriptorSets(setLayout, frameCount);
+	std::println("Created frame data for {} objects over {} frames", m_objectCapacity, frameCount);
+}
+
+void FrameData::CreateDescriptorSets(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount) {
+	std::array poolSizes = {
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eUniformBuffer, .descriptorCount = frameCount },
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 2 * frameCount }
+	};
+
+	vk::DescriptorPoolCreateInfo poolInfo{
+		.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+		.maxSets = frameCount,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data()
+	};
+	m_descriptorPool = vk::raii::DescriptorPool(Device::get(), poolInfo);
+
+	std::vector<vk::DescriptorSetLayout> layouts(frameCount, *setLayout);
+	vk::DescriptorSetAllocateInfo allocInfo{
+		.descriptorPool = *m_descriptorPool,
+		.descriptorSetCount = frameCount,
+		.pSetLayouts = layouts.data()
+	};
+	m_descriptorSets = vk::raii::DescriptorSets(Device::get(), allocInfo);
+
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		vk::DescriptorBufferInfo cameraInfo{
+			.buffer = *m_cameraBuffers[i]->getBuffer(),
+			.offset = 0,
+			.range = sizeof(CameraData)
+		};
+		vk::DescriptorBufferInfo objectsInfo{
+			.buffer = *m_objectBuffers[i]->getBuffer(),
+			.offset = 0,
+			.range = vk::WholeSize
+		};
+		vk::DescriptorBufferInfo instancesInfo{
+			.buffer = *m_instanceBuffers[i]->getBuffer(),
+			.offset = 0,
+			.range = vk::WholeSize
+		};
+
+		std::array descriptorWrites = {
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[i],
+				.dstBinding = 0,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eUniformBuffer,
+				.pBufferInfo = &cameraInfo
+			},
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[i],
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = &objectsInfo
+			},
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[i],
+				.dstBinding = 2,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = &instancesInfo
+			}
+		};
+
+		Device::get().updateDescriptorSets(descriptorWrites, nullptr);
+	}
+}
+
+void FrameData::Bind(CommandEncoder& encoder, const vk::raii::PipelineLayout& pipelineLayout, uint32_t frameIndex) const {
+	encoder.BindDescriptorSets(
+		vk::PipelineBindPoint::eGraphics,
+		*pipelineLayout,
+		0,
+		*m_descriptorSets[frameIndex]
+	);
+}
+
+}
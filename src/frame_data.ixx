@@ -0,0 +1,80 @@
+/// @file frame_data.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+export module vulkan.framedata;
+import vulkan.buffers;
+import vulkan.commandencoder;
+
+namespace vulkan {
+
+/// @brief Per view constants, written once per frame
+export struct CameraData {
+	glm::mat4 view;
+	glm::mat4 proj;
+	glm::mat4 viewProj; // proj * view, what the vertex shader actually uses
+};
+
+/// @brief Per object entry of the frame's object buffer, read by the vertex shader through the instance list
+export struct ObjectData {
+	glm::mat4 model;
+};
+
+/// @brief Camera uniform buffer, storage buffer of ObjectData and instance list per frame, all persistently mapped and bound with a single descriptor set
+/// @note Draws pick an instance slot through firstInstance and the slot names the object entry,
+/// so object entries stay in place and only change when their object does
+export class FrameData {
+public:
+	FrameData(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount, uint32_t objectCapacity);
+
+	/// @brief Camera of a frame, written directly into mapped memory
+	[[nodiscard]]
+	CameraData& camera(uint32_t frameIndex) { return *m_cameraMapped[frameIndex]; }
+
+	/// @brief Object entries of a frame, written directly into mapped memory
+	[[nodiscard]]
+	std::span<ObjectData> objects(uint32_t frameIndex) { return { m_mapped[frameIndex], m_objectCapacity }; }
+
+	/// @brief Object index of every instance slot of a frame, written directly into mapped memory
+	[[nodiscard]]
+	std::span<uint32_t> instances(uint32_t frameIndex) { return { m_instancesMapped[frameIndex], m_objectCapacity }; }
+
+	/// @brief Storage buffer holding the frame's object entries, for passes reading them on the GPU
+	[[nodiscard]]
+	vk::Buffer objectBuffer(uint32_t frameIndex) const { return m_objectBuffers[frameIndex]->handle(); }
+
+	/// @brief Uniform buffer holding the frame's camera, for passes reading it on the GPU
+	[[nodiscard]]
+	vk::Buffer cameraBuffer(uint32_t frameIndex) const { return m_cameraBuffers[frameIndex]->handle(); }
+
+	/// @brief Binds the frame's descriptor set, the encoder drops it when the set is already bound
+	void Bind(CommandEncoder& encoder, const vk::raii::PipelineLayout& pipelineLayout, uint32_t frameIndex) const;
+
+	[[nodiscard]]
+	uint32_t capacity() const { return m_objectCapacity; }
+
+private:
+	void CreateDescriptorSets(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount);
+
+	uint32_t m_objectCapacity;
+	std::vector<std::unique_ptr<Buffer>> m_cameraBuffers;
+	std::vector<CameraData*> m_cameraMapped;
+	std::vector<std::unique_ptr<Buffer>> m_objectBuffers;
+	std::vector<ObjectData*> m_mapped;
+	std::vector<std::unique_ptr<Buffer>> m_instanceBuffers;
+	std::vector<uint32_t*> m_instancesMapped;
+
+	vk::raii::DescriptorPool m_descriptorPool = nullptr;
+	vk::raii::DescriptorSets m_descriptorSets = nullptr;
+};
+
+}
@@ -0,0 +1,326 @@
+/// @file frustum_culling.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define TOAST_CULLING_X86 1
+#endif
+
+// AVX2 kernels are compiled for their own target and only picked when the CPU supports them
+#if defined(TOAST_CULLING_X86) && defined(__GNUC__)
+#define TOAST_CULLING_AVX2 1
+#define TOAST_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+export module frustum_culling;
+import thread_pool;
+
+namespace toast {
+
+/// @brief Frustum planes of a view projection matrix, xyz normal pointing inwards and w distance
+/// @note Points p are inside when dot(plane.xyz, p) + plane.w >= 0 for every plane
+export std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProj) {
+	// Rows of the matrix, glm stores columns
+	auto row = [&viewProj](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+
+	std::array<glm::vec4, 6> planes = {
+		row(3) + row(0), // left
+		row(3) - row(0), // right
+		row(3) + row(1), // bottom
+		row(3) - row(1), // top
+		row(2),          // near, depth goes from 0 to 1
+		row(3) - row(2)  // far
+	};
+	for (glm::vec4& plane : planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return planes;
+}
+
+/// @brief Instruction set the culling kernels run with
+export enum class CullingKernel {
+	eScalar,
+	eSSE,
+	eAVX2
+};
+
+/// @brief Work done by Cull since the last ConsumeStats
+export struct CullingStats {
+	uint64_t tested = 0;
+	uint64_t visible = 0;
+	int64_t time = 0; // ns
+};
+
+/// @brief Bounding spheres kept as structure of arrays and tested against a frustum in parallel
+/// @note Arrays are padded to a whole SIMD register, padding never passes the test
+export class FrustumCuller {
+public:
+	FrustumCuller();
+
+	/// @brief Resizes the bounds, entries that were not set are never visible
+	void Resize(size_t count);
+
+	void SetSphere(size_t index, const glm::vec3& center, float radius);
+
+	/// @brief Tests every sphere against the planes, split over the pool
+	/// @return Ascending indices of the spheres touching the frustum, valid until the next call
+	std::span<const uint32_t> Cull(ThreadPool& pool, const std::array<glm::vec4, 6>& planes);
+
+	/// @brief One sphere at a time on the calling thread, the reference the SIMD kernels have to match
+	void CullReference(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const;
+
+	[[nodiscard]]
+	std::span<const uint32_t> visible() const { return { m_visible.data(), m_visibleCount }; }
+
+	[[nodiscard]]
+	size_t size() const { return m_count; }
+
+	[[nodiscard]]
+	CullingKernel kernel() const { return m_kernel; }
+
+	/// @brief True if this build and CPU can run the kernel
+	[[nodiscard]]
+	static bool Supports(CullingKernel kernel);
+
+	/// @brief Picks the kernel Cull runs with, the widest supported one is picked on construction
+	/// @return False and nothing changes if the kernel is not supported
+	bool SetKernel(CullingKernel kernel);
+
+	CullingStats ConsumeStats() { return std::exchange(m_stats, {}); }
+
+private:
+	struct Spheres {
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* radius;
+	};
+
+	// Spheres per ParallelFor job, a multiple of every register width
+	static constexpr size_t GRAIN_SIZE = 4096;
+	static constexpr size_t LANES = 8;
+
+	static size_t CullScalar(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out);
+#ifdef TOAST_CULLING_X86
+	static size_t CullSSE(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out);
+#endif
+#ifdef TOAST_CULLING_AVX2
+	TOAST_TARGET_AVX2
+	static size_t CullAVX2(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out);
+#endif
+
+	size_t CullRange(const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out) const;
+
+	[[nodiscard]]
+	Spheres spheres() const { return { m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_radius.data() }; }
+
+	size_t m_count = 0;
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_radius;
+
+	// Every job writes its visible indices at its own begin, then they are packed to the front
+	std::vector<uint32_t> m_visible;
+	std::vector<uint32_t> m_jobCounts;
+	size_t m_visibleCount = 0;
+
+	CullingKernel m_kernel = CullingKernel::eScalar;
+	CullingStats m_stats;
+};
+
+FrustumCuller::FrustumCuller() {
+	for (CullingKernel kernel : { CullingKernel::eSSE, CullingKernel::eAVX2 }) {
+		SetKernel(kernel);
+	}
+}
+
+bool FrustumCuller::Supports(CullingKernel kernel) {
+	switch (kernel) {
+	case CullingKernel::eScalar:
+		return true;
+	case CullingKernel::eSSE:
+#ifdef TOAST_CULLING_X86
+		return true;
+#else
+		return false;
+#endif
+	case CullingKernel::eAVX2:
+#ifdef TOAST_CULLING_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+bool FrustumCuller::SetKernel(CullingKernel kernel) {
+	if (!Supports(kernel)) {
+		return false;
+	}
+	m_kernel = kernel;
+	return true;
+}
+
+void FrustumCuller::Resize(size_t count) {
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	m_count = count;
+	m_centerX.resize(padded, 0.0f);
+	m_centerY.resize(padded, 0.0f);
+	m_centerZ.resize(padded, 0.0f);
+	m_radius.resize(padded, -std::numeric_limits<float>::infinity());
+	std::fill(m_radius.begin() + count, m_radius.end(), -std::numeric_limits<float>::infinity());
+
+	m_visible.resize(padded);
+	m_jobCounts.resize((padded + GRAIN_SIZE - 1) / GRAIN_SIZE);
+	m_visibleCount = 0;
+}
+
+void FrustumCuller::SetSphere(size_t index, const glm::vec3& center, float radius) {
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_radius[index] = radius;
+}
+
+std::span<const uint32_t> FrustumCuller::Cull(ThreadPool& pool, const std::array<glm::vec4, 6>& planes) {
+	auto start = std::chrono::steady_clock::now();
+
+	pool.ParallelFor(m_radius.size(), GRAIN_SIZE, [&](size_t begin, size_t end) {
+		m_jobCounts[begin / GRAIN_SIZE] = static_cast<uint32_t>(CullRange(planes, begin, end, m_visible.data() + begin));
+	});
+
+	// Jobs never write past their own begin, packing front to back only moves entries down
+	m_visibleCount = 0;
+	for (size_t job = 0; job < m_jobCounts.size(); ++job) {
+		uint32_t count = m_jobCounts[job];
+		if (count > 0 && m_visibleCount != job * GRAIN_SIZE) {
+			std::memmove(m_visible.data() + m_visibleCount, m_visible.data() + job * GRAIN_SIZE, count * sizeof(uint32_t));
+		}
+		m_visibleCount += count;
+	}
+
+	m_stats.tested += m_count;
+	m_stats.visible += m_visibleCount;
+	m_stats.time += (std::chrono::steady_clock::now() - start).count();
+
+	return visible();
+}
+
+void FrustumCuller::CullReference(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& visible) const {
+	visible.resize(m_radius.size());
+	visible.resize(CullScalar(spheres(), planes, 0, m_radius.size(), visible.data()));
+}
+
+size_t FrustumCuller::CullRange(const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out) const {
+	switch (m_kernel) {
+#ifdef TOAST_CULLING_AVX2
+	case CullingKernel::eAVX2:
+		return CullAVX2(spheres(), planes, begin, end, out);
+#endif
+#ifdef TOAST_CULLING_X86
+	case CullingKernel::eSSE:
+		return CullSSE(spheres(), planes, begin, end, out);
+#endif
+	default:
+		return CullScalar(spheres(), planes, begin, end, out);
+	}
+}
+
+// Every kernel evaluates ((x * a + y * b) + z * c) + d in the same order, so they agree bit for bit
+size_t FrustumCuller::CullScalar(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out) {
+	size_t count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		bool inside = true;
+		for (const glm::vec4& plane : planes) {
+			float distance = spheres.x[i] * plane.x + spheres.y[i] * plane.y + spheres.z[i] * plane.z + plane.w;
+			inside &= distance >= -spheres.radius[i];
+		}
+		if (inside) {
+			out[count++] = static_cast<uint32_t>(i);
+		}
+	}
+	return count;
+}
+
+#ifdef TOAST_CULLING_X86
+size_t FrustumCuller::CullSSE(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out) {
+	__m128 a[6], b[6], c[6], d[6];
+	for (size_t p = 0; p < planes.size(); ++p) {
+		a[p] = _mm_set1_ps(planes[p].x);
+		b[p] = _mm_set1_ps(planes[p].y);
+		c[p] = _mm_set1_ps(planes[p].z);
+		d[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	size_t count = 0;
+	for (size_t i = begin; i < end; i += 4) {
+		__m128 x = _mm_loadu_ps(spheres.x + i);
+		__m128 y = _mm_loadu_ps(spheres.y + i);
+		__m128 z = _mm_loadu_ps(spheres.z + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + i));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (size_t p = 0; p < planes.size(); ++p) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, a[p]), _mm_mul_ps(y, b[p])), _mm_mul_ps(z, c[p])), d[p]);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		for (unsigned mask = static_cast<unsigned>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+			out[count++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+		}
+	}
+	return count;
+}
+#endif
+
+#ifdef TOAST_CULLING_AVX2
+TOAST_TARGET_AVX2
+size_t FrustumCuller::CullAVX2(const Spheres& spheres, const std::array<glm::vec4, 6>& planes, size_t begin, size_t end, uint32_t* out) {
+	__m256 a[6], b[6], c[6], d[6];
+	for (size_t p = 0; p < planes.size(); ++p) {
+		a[p] = _mm256_set1_ps(planes[p].x);
+		b[p] = _mm256_set1_ps(planes[p].y);
+		c[p] = _mm256_set1_ps(planes[p].z);
+		d[p] = _mm256_set1_ps(planes[p].w);
+	}
+
+	size_t count = 0;
+	for (size_t i = begin; i < end; i += 8) {
+		__m256 x = _mm256_loadu_ps(spheres.x + i);
+		__m256 y = _mm256_loadu_ps(spheres.y + i);
+		__m256 z = _mm256_loadu_ps(spheres.z + i);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + i));
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (size_t p = 0; p < planes.size(); ++p) {
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, a[p]), _mm256_mul_ps(y, b[p])), _mm256_mul_ps(z, c[p])), d[p]);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+		}
+
+		for (unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+			out[count++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+		}
+	}
+	return count;
+}
+#endif
+
+}
@@ -0,0 +1,191 @@
+/// @file geometry_arena.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <span>
+#include <vector>
+
+module vulkan.geometryarena;
+import vulkan.buffers;
+import vulkan.device;
+import vulkan.commandpool;
+import vulkan.commandbuffer;
+import vulkan.commandencoder;
+
+namespace vulkan {
+
+////////////////////////////////////////////////////////////////////////////////////
+/// Range Allocator
+////////////////////////////////////////////////////////////////////////////////////
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+	: m_capacity(capacity)
+{
+	m_free.emplace(0, capacity);
+}
+
+std::optional<uint32_t> RangeAllocator::Allocate(uint32_t count) {
+	for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+		auto [first, freeCount] = *it;
+		if (freeCount < count) continue;
+
+		m_free.erase(it);
+		if (freeCount > count) {
+			m_free.emplace(first + count, freeCount - count);
+		}
+		m_used += count;
+		return first;
+	}
+	return std::nullopt;
+}
+
+void RangeAllocator::Free(uint32_t first, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+	m_used -= count;
+
+	auto next = m_free.lower_bound(first);
+	if (next != m_free.end() && first + count == next->first) {
+		count += next->second;
+		next = m_free.erase(next);
+	}
+	if (next != m_free.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == first) {
+			previous->second += count;
+			return;
+		}
+	}
+	m_free.emplace(first, count);
+}
+
+void RangeAllocator::Reset(uint32_t used) {
+	m_free.clear();
+	if (used < m_capacity) {
+		m_free.emplace(used, m_capacity - used);
+	}
+	m_used = used;
+}
+
+uint32_t RangeAllocator::holes() const {
+	uint32_t count = static_cast<uint32_t>(m_free.size());
+	if (!m_free.empty()) {
+		auto last = std::prev(m_free.end());
+		if (last->first + last->second == m_capacity) count--;
+	}
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+/// Geometry Arena
+////////////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::GeometryArena(vk::DeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+	: m_vertexStride(vertexStride)
+	, m_vertices(vertexCapacity)
+	, m_indices(indexCapacity)
+	, m_vertexBuffer(CreateVertexBuffer(vertexStride * vertexCapacity))
+	, m_indexBuffer(CreateIndexBuffer(sizeof(uint32_t) * indexCapacity))
+{
+	std::println("Created geometry arena for {} vertices and {} indices", vertexCapacity, indexCapacity);
+}
+
+Buffer GeometryArena::CreateVertexBuffer(vk::DeviceSize size) {
+	return Buffer(
+		size,
+		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	);
+}
+
+Buffer GeometryArena::CreateIndexBuffer(vk::DeviceSize size) {
+	return Buffer(
+		size,
+		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	);
+}
+
+std::optional<ArenaRange> GeometryArena::AllocateVertices(uint32_t count) {
+	auto first = m_vertices.Allocate(count);
+	if (!first) return std::nullopt;
+	return ArenaRange{ .first = *first, .count = count };
+}
+
+std::optional<ArenaRange> GeometryArena::AllocateIndices(uint32_t count) {
+	auto first = m_indices.Allocate(count);
+	if (!first) return std::nullopt;
+	return ArenaRange{ .first = *first, .count = count };
+}
+
+void GeometryArena::FreeVertices(const ArenaRange& range) {
+	m_vertices.Free(range.first, range.count);
+}
+
+void GeometryArena::FreeIndices(const ArenaRange& range) {
+	m_indices.Free(range.first, range.count);
+}
+
+void GeometryArena::Compact(std::span<ArenaRange* const> vertexRanges, std::span<ArenaRange* const> indexRanges) {
+	// Copies can't overlap inside one buffer, pack everything into fresh buffers instead
+	Buffer vertexBuffer = CreateVertexBuffer(m_vertexStride * m_vertices.capacity());
+	Buffer indexBuffer = CreateIndexBuffer(sizeof(uint32_t) * m_indices.capacity());
+
+	auto pack = [](std::span<ArenaRange* const> ranges, vk::DeviceSize stride) {
+		std::vector<ArenaRange*> sorted(ranges.begin(), ranges.end());
+		std::ranges::sort(sorted, {}, &ArenaRange::first);
+
+		std::vector<vk::BufferCopy> copies;
+		uint32_t next = 0;
+		for (ArenaRange* range : sorted) {
+			if (range->count == 0) continue;
+			copies.push_back(vk::BufferCopy(range->first * stride, next * stride, range->count * stride));
+			range->first = next;
+			next += range->count;
+		}
+		return std::pair{ copies, next };
+	};
+
+	auto [vertexCopies, vertexCount] = pack(vertexRanges, m_vertexStride);
+	auto [indexCopies, indexCount] = pack(indexRanges, sizeof(uint32_t));
+
+	// Nothing may still read the old buffers or write them through an upload
+	{
+		std::lock_guard<std::mutex> lock(Device::queueMutex());
+		Device::get().waitIdle();
+	}
+	CommandBuffer::ExecuteImmediate(
+		CommandPool::GetForCurrentThread().get(),
+		[&](vk::raii::CommandBuffer& cmd) {
+			if (!vertexCopies.empty()) cmd.copyBuffer(m_vertexBuffer.handle(), vertexBuffer.handle(), vertexCopies);
+			if (!indexCopies.empty()) cmd.copyBuffer(m_indexBuffer.handle(), indexBuffer.handle(), indexCopies);
+		}
+	);
+
+	uint32_t vertexHoles = m_vertices.holes();
+	uint32_t indexHoles = m_indices.holes();
+	m_vertexBuffer = std::move(vertexBuffer);
+	m_indexBuffer = std::move(indexBuffer);
+	m_vertices.Reset(vertexCount);
+	m_indices.Reset(indexCount);
+
+	std::println("Compacted geometry arena: removed {} holes in vertices and {} in indices, {} vertices and {} indices in use",
+		vertexHoles, indexHoles, vertexCount, indexCount);
+}
+
+void GeometryArena::Bind(CommandEncoder& encoder) const {
+	vk::Buffer vertexBuffer = m_vertexBuffer.handle();
+	vk::DeviceSize offset = 0;
+	encoder.BindVertexBuffers(0, vertexBuffer, offset);
+	encoder.BindIndexBuffer(m_indexBuffer.handle(), 0, vk::IndexType::eUint32);
+}
+
+}
@@ -0,0 +1,94 @@
+/// @file geometry_arena.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+
+export module vulkan.geometryarena;
+import vulkan.buffers;
+import vulkan.commandencoder;
+
+namespace vulkan {
+
+/// @brief Elements [first, first + count) of one of the arena's buffers
+export struct ArenaRange {
+	uint32_t first = 0;
+	uint32_t count = 0;
+};
+
+/// @brief First fit allocator over element indices, freed ranges merge with their neighbours
+export class RangeAllocator {
+public:
+	explicit RangeAllocator(uint32_t capacity);
+
+	/// @brief Lowest free range that fits, holes are reused before the untouched tail
+	std::optional<uint32_t> Allocate(uint32_t count);
+	void Free(uint32_t first, uint32_t count);
+
+	/// @brief Everything below used is taken, everything above is free
+	void Reset(uint32_t used);
+
+	[[nodiscard]]
+	uint32_t used() const { return m_used; }
+	[[nodiscard]]
+	uint32_t capacity() const { return m_capacity; }
+	/// @brief Free ranges that are not the tail, what compaction gets rid of
+	[[nodiscard]]
+	uint32_t holes() const;
+
+private:
+	std::map<uint32_t, uint32_t> m_free; // first -> count
+	uint32_t m_capacity;
+	uint32_t m_used = 0;
+};
+
+/// @brief One device local vertex buffer and one index buffer that every geometry is a sub-range of
+/// @note Bound once per command buffer, draws select their geometry with firstIndex and vertexOffset
+export class GeometryArena {
+public:
+	GeometryArena(vk::DeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+	[[nodiscard]]
+	std::optional<ArenaRange> AllocateVertices(uint32_t count);
+	[[nodiscard]]
+	std::optional<ArenaRange> AllocateIndices(uint32_t count);
+	void FreeVertices(const ArenaRange& range);
+	void FreeIndices(const ArenaRange& range);
+
+	/// @brief Moves every live range down so the free space is one block at the end
+	/// @note Ranges are updated in place, whatever they do not cover is freed. Waits for the device to be idle,
+	/// anything recorded with the old offsets has to be recorded again
+	void Compact(std::span<ArenaRange* const> vertexRanges, std::span<ArenaRange* const> indexRanges);
+
+	void Bind(CommandEncoder& encoder) const;
+
+	[[nodiscard]]
+	vk::Buffer vertexBuffer() const { return m_vertexBuffer.handle(); }
+	[[nodiscard]]
+	vk::Buffer indexBuffer() const { return m_indexBuffer.handle(); }
+	[[nodiscard]]
+	vk::DeviceSize vertexStride() const { return m_vertexStride; }
+
+	[[nodiscard]]
+	const RangeAllocator& vertices() const { return m_vertices; }
+	[[nodiscard]]
+	const RangeAllocator& indices() const { return m_indices; }
+
+private:
+	static Buffer CreateVertexBuffer(vk::DeviceSize size);
+	static Buffer CreateIndexBuffer(vk::DeviceSize size);
+
+	vk::DeviceSize m_vertexStride;
+	RangeAllocator m_vertices;
+	RangeAllocator m_indices;
+	Buffer m_vertexBuffer;
+	Buffer m_indexBuffer;
+};
+
+}
@@ -0,0 +1,202 @@
+/// @file geometry_registry.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <mutex>
+#include <print>
+#include <span>
+#include <stdexcept>
+
+module vulkan.geometry;
+import vulkan.geometryarena;
+import vulkan.upload;
+
+namespace vulkan {
+
+Geometry::Geometry(uint32_t id, GeometryArena& arena, ArenaRange vertices, ArenaRange indices)
+	: m_id(id)
+	, m_arena(arena)
+	, m_vertices(vertices)
+	, m_indices(indices)
+{
+}
+
+Geometry::~Geometry() {
+	GeometryRegistry::get().Release(*this);
+}
+
+GeometryRegistry::GeometryRegistry(vk::DeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+	: m_arena(vertexStride, vertexCapacity, indexCapacity)
+{
+	if (m_thisGeometryRegistry) {
+		throw std::runtime_error("One Geometry Registry already exists");
+	}
+	m_thisGeometryRegistry = this;
+}
+
+GeometryRegistry::~GeometryRegistry() {
+	m_thisGeometryRegistry = nullptr;
+}
+
+GeometryRegistry* GeometryRegistry::geometryRegistry() {
+	if (!m_thisGeometryRegistry) {
+		throw std::runtime_error("Trying to access Geometry Registry but it doesn't exist yet");
+	}
+	return m_thisGeometryRegistry;
+}
+
+uint64_t GeometryRegistry::Hash(std::span<const std::byte> vertices, std::span<const uint32_t> indices) {
+	// FNV-1a over both streams, with the vertex size mixed in so the split point matters
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](std::span<const std::byte> bytes) {
+		for (std::byte byte : bytes) {
+			hash ^= static_cast<uint64_t>(byte);
+			hash *= 1099511628211ull;
+		}
+	};
+
+	uint64_t vertexBytes = vertices.size_bytes();
+	mix(std::as_bytes(std::span(&vertexBytes, 1)));
+	mix(vertices);
+	mix(std::as_bytes(indices));
+	return hash;
+}
+
+std::shared_ptr<const Geometry> GeometryRegistry::Acquire(std::span<const std::byte> vertices, std::span<const uint32_t> indices) {
+	uint32_t vertexCount = static_cast<uint32_t>(vertices.size_bytes() / m_arena.vertexStride());
+	uint32_t indexCount = static_cast<uint32_t>(indices.size());
+	Key key{ .hash = Hash(vertices, indices), .vertexCount = vertexCount, .indexCount = indexCount };
+
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	m_stats.requests++;
+
+	auto [first, last] = m_entries.equal_range(key);
+	bool collided = false;
+	for (auto it = first; it != last; ++it) {
+		auto geometry = it->second.geometry.lock();
+		if (!geometry) continue;
+		if (std::ranges::equal(it->second.vertices, vertices) && std::ranges::equal(it->second.indices, indices)) {
+			m_stats.bytesDeduplicated += geometry->size();
+			return geometry;
+		}
+		collided = true;
+	}
+	if (collided) {
+		m_stats.collisions++;
+	}
+
+	// Drop what expired since the last miss so the map doesn't only grow
+	std::erase_if(m_entries, [](const auto& item) { return item.second.geometry.expired(); });
+
+	auto allocate = [&]() -> std::optional<std::pair<ArenaRange, ArenaRange>> {
+		auto vertexRange = m_arena.AllocateVertices(vertexCount);
+		if (!vertexRange) return std::nullopt;
+		auto indexRange = indexCount > 0 ? m_arena.AllocateIndices(indexCount) : ArenaRange{};
+		if (!indexRange) {
+			m_arena.FreeVertices(*vertexRange);
+			return std::nullopt;
+		}
+		return std::pair{ *vertexRange, *indexRange };
+	};
+
+	auto ranges = allocate();
+	if (!ranges) {
+		CompactLocked();
+		ranges = allocate();
+		if (!ranges) {
+			throw std::runtime_error("Geometry arena is full");
+		}
+	}
+	auto [vertexRange, indexRange] = *ranges;
+
+	// Staged through the upload manager, batched with the other geometry on the transfer queue
+	UploadManager::get().Upload(m_arena.vertexBuffer(), vertices.data(), vertices.size_bytes(),
+		vertexRange.first * m_arena.vertexStride());
+	if (indexCount > 0) {
+		UploadManager::get().Upload(m_arena.indexBuffer(), indices.data(), indices.size_bytes(),
+			indexRange.first * sizeof(uint32_t));
+	}
+
+	auto geometry = std::make_shared<Geometry>(m_nextId++, m_arena, vertexRange, indexRange);
+	m_entries.emplace(key, Entry{
+		.geometry = geometry,
+		.vertices = std::vector<std::byte>(vertices.begin(), vertices.end()),
+		.indices = std::vector<uint32_t>(indices.begin(), indices.end())
+	});
+	m_stats.uploads++;
+	m_stats.bytesUploaded += geometry->size();
+	return geometry;
+}
+
+void GeometryRegistry::Release(const Geometry& geometry) {
+	// Frames in flight and retained secondaries can still read the ranges, the next upload must not land in them
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	m_retired.push_back(RetiredRanges{ .vertices = geometry.m_vertices, .indices = geometry.m_indices, .frame = m_pendingFrame });
+}
+
+void GeometryRegistry::AdvanceFrame(uint64_t pendingFrame, uint64_t completedFrames) {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	m_pendingFrame = pendingFrame;
+	while (!m_retired.empty() && m_retired.front().frame <= completedFrames) {
+		m_arena.FreeVertices(m_retired.front().vertices);
+		m_arena.FreeIndices(m_retired.front().indices);
+		m_retired.pop_front();
+	}
+}
+
+void GeometryRegistry::Compact() {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	CompactLocked();
+}
+
+void GeometryRegistry::CompactLocked() {
+	// Uploads still in flight target the old buffers
+	UploadManager::get().Wait(UploadManager::get().Flush());
+
+	std::vector<std::shared_ptr<Geometry>> alive;
+	std::vector<ArenaRange*> vertexRanges;
+	std::vector<ArenaRange*> indexRanges;
+	for (auto& [key, entry] : m_entries) {
+		if (auto geometry = entry.geometry.lock()) {
+			vertexRanges.push_back(&geometry->m_vertices);
+			indexRanges.push_back(&geometry->m_indices);
+			alive.push_back(std::move(geometry));
+		}
+	}
+	m_arena.Compact(vertexRanges, indexRanges);
+
+	// Compacting waited for the device, nothing reads the retired ranges anymore and packing dropped them
+	m_retired.clear();
+	m_generation.fetch_add(1, std::memory_order_release);
+}
+
+GeometryRegistry::Stats GeometryRegistry::stats() const {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	Stats current = m_stats;
+	current.alive = 0;
+	for (const auto& [key, entry] : m_entries) {
+		if (!entry.geometry.expired()) current.alive++;
+	}
+	return current;
+}
+
+void GeometryRegistry::DumpStats() const {
+	Stats current = stats();
+	std::println("Geometry: {} requests, {} uploaded ({:.1f} KiB, {} hash collisions), {} alive, {:.1f} KiB of uploads and VRAM saved by sharing",
+		current.requests, current.uploads, current.bytesUploaded / 1024.0, current.collisions, current.alive, current.bytesDeduplicated / 1024.0);
+	std::println("Geometry arena: {}/{} vertices, {}/{} indices, {} + {} holes",
+		m_arena.vertices().used(), m_arena.vertices().capacity(), m_arena.indices().used(), m_arena.indices().capacity(),
+		m_arena.vertices().holes(), m_arena.indices().holes());
+}
+
+}
@@ -0,0 +1,154 @@
+/// @file geometry_registry.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+export module vulkan.geometry;
+import vulkan.geometryarena;
+
+namespace vulkan {
+
+export class GeometryRegistry;
+
+/// @brief Vertices and indices in the geometry arena, shared by every mesh with the same content
+export class Geometry {
+public:
+	Geometry(uint32_t id, GeometryArena& arena, ArenaRange vertices, ArenaRange indices);
+	~Geometry();
+
+	Geometry(const Geometry&) = delete;
+	Geometry& operator=(const Geometry&) = delete;
+
+	[[nodiscard]]
+	uint32_t id() const { return m_id; }
+	[[nodiscard]]
+	const GeometryArena& arena() const { return m_arena; }
+	[[nodiscard]]
+	uint32_t firstVertex() const { return m_vertices.first; }
+	[[nodiscard]]
+	uint32_t vertexCount() const { return m_vertices.count; }
+	[[nodiscard]]
+	uint32_t firstIndex() const { return m_indices.first; }
+	[[nodiscard]]
+	uint32_t indexCount() const { return m_indices.count; }
+	[[nodiscard]]
+	vk::DeviceSize size() const { return m_vertices.count * m_arena.vertexStride() + m_indices.count * sizeof(uint32_t); }
+
+private:
+	friend class GeometryRegistry; // moves the ranges when compacting
+
+	uint32_t m_id;
+	GeometryArena& m_arena;
+	ArenaRange m_vertices;
+	ArenaRange m_indices;
+};
+
+/// @brief Hands out one copy in the geometry arena per distinct vertex and index content
+/// @note Entries are keyed by a 64 bit hash of the bytes and the element counts, and live for as long as a mesh
+/// references them. A hit is only taken once the bytes match too, a hash collision uploads its own copy
+export class GeometryRegistry {
+public:
+	GeometryRegistry(vk::DeviceSize vertexStride, uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+	~GeometryRegistry();
+	static GeometryRegistry* geometryRegistry();
+
+	[[nodiscard]]
+	static GeometryRegistry& get() { return *geometryRegistry(); }
+
+	static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1u << 20;
+	static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1u << 22;
+
+	struct Stats {
+		uint32_t requests = 0;
+		uint32_t uploads = 0;           // requests that created a new geometry
+		uint32_t collisions = 0;        // uploads whose key matched a live geometry with other content
+		uint32_t alive = 0;             // geometries currently referenced
+		vk::DeviceSize bytesUploaded = 0;
+		vk::DeviceSize bytesDeduplicated = 0; // uploads and VRAM saved by sharing
+	};
+
+	/// @brief Returns the geometry with this content, uploading it only the first time it is seen
+	/// @note Compacts the arena if it is too fragmented for the new geometry, which bumps generation()
+	[[nodiscard]]
+	std::shared_ptr<const Geometry> Acquire(std::span<const std::byte> vertices, std::span<const uint32_t> indices);
+
+	/// @brief Packs every live geometry at the start of the arena, see GeometryArena::Compact
+	void Compact();
+
+	/// @brief Gives the arena back what released geometries used once the GPU is done with it
+	/// @param pendingFrame Frame timeline value of the frame being built, what is released from now on waits for it
+	/// @param completedFrames Current value of the frame timeline
+	void AdvanceFrame(uint64_t pendingFrame, uint64_t completedFrames);
+
+	[[nodiscard]]
+	const GeometryArena& arena() const { return m_arena; }
+
+	/// @brief Bumped by every compaction. Anything that baked arena buffers or geometry offsets,
+	/// like recorded command buffers or uploaded draw data, is stale once this changes
+	[[nodiscard]]
+	uint64_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
+	[[nodiscard]]
+	Stats stats() const;
+
+	void DumpStats() const;
+
+private:
+	friend class Geometry; // gives its ranges back through Release
+
+	struct Key {
+		uint64_t hash;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash); }
+	};
+
+	/// @brief The content is kept on the CPU as well, a hit has to match it byte for byte
+	struct Entry {
+		std::weak_ptr<Geometry> geometry;
+		std::vector<std::byte> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	/// @brief Ranges of a released geometry, frames up to this timeline value may still read them
+	struct RetiredRanges {
+		ArenaRange vertices;
+		ArenaRange indices;
+		uint64_t frame;
+	};
+
+	static uint64_t Hash(std::span<const std::byte> vertices, std::span<const uint32_t> indices);
+	void CompactLocked();
+	void Release(const Geometry& geometry);
+
+	static GeometryRegistry* m_thisGeometryRegistry;
+	mutable std::recursive_mutex m_mutex; // the last reference of a geometry can drop while compacting
+	GeometryArena m_arena;
+	std::unordered_multimap<Key, Entry, KeyHash> m_entries;
+	std::deque<RetiredRanges> m_retired; // in frame order, frames only ever grow
+	uint64_t m_pendingFrame = 0;
+	uint32_t m_nextId = 0;
+	std::atomic<uint64_t> m_generation = 0;
+	Stats m_stats;
+};
+
+GeometryRegistry* GeometryRegistry::m_thisGeometryRegistry = nullptr;
+
+}
@@ -0,0 +1,324 @@
+/// @file gpu_culling.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+module vulkan.gpuculling;
+import vulkan.buffers;
+import vulkan.device;
+import vulkan.pipeline;
+import vulkan.upload;
+import vulkan.commandbuffer;
+import vulkan.depthpyramid;
+import frustum_culling;
+
+namespace vulkan {
+
+GpuCulling::GpuCulling(uint32_t frameCount, uint32_t maxObjects, bool occlusion)
+	: m_maxObjects(std::max(maxObjects, 1u))
+	, m_occlusion(occlusion)
+{
+	m_drawObjects = std::make_unique<Buffer>(
+		sizeof(DrawObject) * m_maxObjects,
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	);
+	m_visibility = std::make_unique<Buffer>(
+		sizeof(uint32_t) * m_maxObjects,
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	);
+
+	// The second pass appends its own list behind the first one
+	uint32_t passCount = m_occlusion ? 2 : 1;
+	m_frames.resize(frameCount);
+	for (FrameBuffers& frame : m_frames) {
+		frame.commands = std::make_unique<Buffer>(
+			sizeof(vk::DrawIndexedIndirectCommand) * m_maxObjects * passCount,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+			vk::MemoryPropertyFlagBits::eDeviceLocal
+		);
+		frame.count = std::make_unique<Buffer>(
+			sizeof(uint32_t) * eCounterCount,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+				| vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eDeviceLocal
+		);
+		frame.readback = std::make_unique<Buffer>(
+			sizeof(uint32_t) * eCounterCount,
+			vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		);
+	}
+
+	CreatePipeline();
+	CreateDescriptorSets(frameCount);
+	std::println("Created GPU culling for up to {} objects{}", m_maxObjects, m_occlusion ? " with occlusion" : "");
+}
+
+void GpuCulling::CreatePipeline() {
+	// Objects, draw objects, commands, counters, camera, visibility and depth pyramid
+	std::array<vk::DescriptorSetLayoutBinding, 7> bindings;
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i] = vk::DescriptorSetLayoutBinding{
+			.binding = i,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eCompute
+		};
+	}
+	bindings[4].descriptorType = vk::DescriptorType::eUniformBuffer;
+	bindings[6].descriptorType = vk::DescriptorType::eSampledImage;
+	m_descriptorSetLayout = vk::raii::DescriptorSetLayout(Device::get(), vk::DescriptorSetLayoutCreateInfo{
+		.bindingCount = static_cast<uint32_t>(bindings.size()),
+		.pBindings = bindings.data()
+	});
+
+	vk::PushConstantRange pushConstants{
+		.stageFlags = vk::ShaderStageFlagBits::eCompute,
+		.offset = 0,
+		.size = sizeof(CullParams)
+	};
+	m_pipelineLayout = vk::raii::PipelineLayout(Device::get(), vk::PipelineLayoutCreateInfo{
+		.setLayoutCount = 1,
+		.pSetLayouts = &*m_descriptorSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushConstants
+	});
+
+	auto code = ReadFile("cull.spv");
+	vk::raii::ShaderModule shaderModule(Device::get(), vk::ShaderModuleCreateInfo{
+		.codeSize = code.size(),
+		.pCode = reinterpret_cast<const uint32_t*>(code.data())
+	});
+
+	m_pipeline = vk::raii::Pipeline(Device::get(), nullptr, vk::ComputePipelineCreateInfo{
+		.stage = {
+			.stage = vk::ShaderStageFlagBits::eCompute,
+			.module = shaderModule,
+			.pName = "cullMain"
+		},
+		.layout = *m_pipelineLayout
+	});
+
+	// Only this entry point reads the camera, visibility and pyramid, so plain culling never needs them written
+	if (m_occlusion) {
+		m_occlusionPipeline = vk::raii::Pipeline(Device::get(), nullptr, vk::ComputePipelineCreateInfo{
+			.stage = {
+				.stage = vk::ShaderStageFlagBits::eCompute,
+				.module = shaderModule,
+				.pName = "occlusionMain"
+			},
+			.layout = *m_pipelineLayout
+		});
+	}
+}
+
+void GpuCulling::CreateDescriptorSets(uint32_t frameCount) {
+	std::array poolSizes = {
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 5 * frameCount },
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eUniformBuffer, .descriptorCount = frameCount },
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eSampledImage, .descriptorCount = frameCount }
+	};
+	m_descriptorPool = vk::raii::DescriptorPool(Device::get(), vk::DescriptorPoolCreateInfo{
+		.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+		.maxSets = frameCount,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data()
+	});
+
+	std::vector<vk::DescriptorSetLayout> layouts(frameCount, *m_descriptorSetLayout);
+	m_descriptorSets = vk::raii::DescriptorSets(Device::get(), vk::DescriptorSetAllocateInfo{
+		.descriptorPool = *m_descriptorPool,
+		.descriptorSetCount = frameCount,
+		.pSetLayouts = layouts.data()
+	});
+
+	// Bindings 0 and 4 are the frame's object data and camera, written by SetFrameBuffers
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		std::array bufferInfos = {
+			vk::DescriptorBufferInfo{ .buffer = m_drawObjects->handle(), .offset = 0, .range = vk::WholeSize },
+			vk::DescriptorBufferInfo{ .buffer = m_frames[i].commands->handle(), .offset = 0, .range = vk::WholeSize },
+			vk::DescriptorBufferInfo{ .buffer = m_frames[i].count->handle(), .offset = 0, .range = vk::WholeSize }
+		};
+		vk::DescriptorBufferInfo visibilityInfo{ .buffer = m_visibility->handle(), .offset = 0, .range = vk::WholeSize };
+		std::array writes = {
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[i],
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = static_cast<uint32_t>(bufferInfos.size()),
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = bufferInfos.data()
+			},
+			vk::WriteDescriptorSet{
+				.dstSet = *m_descriptorSets[i],
+				.dstBinding = 5,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = &visibilityInfo
+			}
+		};
+		Device::get().updateDescriptorSets(writes, nullptr);
+	}
+}
+
+void GpuCulling::SetObjects(std::span<const DrawObject> objects) {
+	if (objects.size() > m_maxObjects) {
+		throw std::runtime_error("More objects than GPU culling was created for");
+	}
+	m_objectCount = static_cast<uint32_t>(objects.size());
+	if (!objects.empty()) {
+		UploadManager::get().Upload(m_drawObjects->handle(), objects.data(), objects.size_bytes());
+
+		// Nothing counts as visible last frame, the first frame draws everything in the second pass
+		std::vector<uint32_t> visibility(objects.size(), 0);
+		UploadManager::get().Upload(m_visibility->handle(), visibility.data(), visibility.size() * sizeof(uint32_t));
+	}
+}
+
+void GpuCulling::SetFrameBuffers(uint32_t frameIndex, vk::Buffer objectBuffer, vk::Buffer cameraBuffer) {
+	vk::DescriptorBufferInfo objectInfo{ .buffer = objectBuffer, .offset = 0, .range = vk::WholeSize };
+	vk::DescriptorBufferInfo cameraInfo{ .buffer = cameraBuffer, .offset = 0, .range = vk::WholeSize };
+	std::array writes = {
+		vk::WriteDescriptorSet{
+			.dstSet = *m_descriptorSets[frameIndex],
+			.dstBinding = 0,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.pBufferInfo = &objectInfo
+		},
+		vk::WriteDescriptorSet{
+			.dstSet = *m_descriptorSets[frameIndex],
+			.dstBinding = 4,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eUniformBuffer,
+			.pBufferInfo = &cameraInfo
+		}
+	};
+	Device::get().updateDescriptorSets(writes, nullptr);
+}
+
+void GpuCulling::SetDepthPyramid(const DepthPyramid& pyramid) {
+	m_pyramidExtent = pyramid.extent();
+	m_pyramidLevels = pyramid.levelCount();
+
+	vk::DescriptorImageInfo imageInfo{ .imageView = pyramid.image().view(), .imageLayout = vk::ImageLayout::eGeneral };
+	for (uint32_t i = 0; i < m_frames.size(); ++i) {
+		vk::WriteDescriptorSet write{
+			.dstSet = *m_descriptorSets[i],
+			.dstBinding = 6,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eSampledImage,
+			.pImageInfo = &imageInfo
+		};
+		Device::get().updateDescriptorSets(write, nullptr);
+	}
+}
+
+void GpuCulling::Cull(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj) const {
+	const FrameBuffers& frame = m_frames[frameIndex];
+
+	// Last frame's second pass wrote the visibility this pass reads
+	cmdBuffer.fillBuffer(frame.count->handle(), 0, sizeof(uint32_t) * eCounterCount, 0);
+	CommandBuffer::GlobalBarrier(
+		cmdBuffer,
+		vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+		vk::PipelineStageFlagBits2::eComputeShader
+	);
+
+	Dispatch(cmdBuffer, frameIndex, viewProj, 0);
+}
+
+void GpuCulling::CullOccluded(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj) const {
+	if (!m_occlusion) {
+		throw std::runtime_error("GPU culling was created without occlusion");
+	}
+	Dispatch(cmdBuffer, frameIndex, viewProj, 1);
+}
+
+void GpuCulling::Dispatch(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj, uint32_t pass) const {
+	CullParams params{
+		.planes = toast::ExtractFrustumPlanes(viewProj),
+		.objectCount = m_objectCount,
+		.pass = pass,
+		.pyramidWidth = m_pyramidExtent.width,
+		.pyramidHeight = m_pyramidExtent.height,
+		.pyramidLevels = m_pyramidLevels
+	};
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_occlusion ? m_occlusionPipeline : m_pipeline);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout, 0, *m_descriptorSets[frameIndex], nullptr);
+	cmdBuffer.pushConstants<CullParams>(*m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, params);
+	cmdBuffer.dispatch((m_objectCount + 63) / 64, 1, 1);
+
+	CommandBuffer::GlobalBarrier(
+		cmdBuffer,
+		vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::AccessFlagBits2::eIndirectCommandRead,
+		vk::PipelineStageFlagBits2::eComputeShader,
+		vk::PipelineStageFlagBits2::eDrawIndirect
+	);
+}
+
+void GpuCulling::Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, uint32_t pass) const {
+	const FrameBuffers& frame = m_frames[frameIndex];
+	constexpr vk::DeviceSize stride = sizeof(vk::DrawIndexedIndirectCommand);
+	cmdBuffer.drawIndexedIndirectCount(frame.commands->handle(), pass * m_objectCount * stride, frame.count->handle(),
+		pass * sizeof(uint32_t), m_objectCount, stride);
+}
+
+void GpuCulling::ResolveStats(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex) {
+	FrameBuffers& frame = m_frames[frameIndex];
+	CommandBuffer::GlobalBarrier(
+		cmdBuffer,
+		vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::AccessFlagBits2::eTransferRead,
+		vk::PipelineStageFlagBits2::eComputeShader,
+		vk::PipelineStageFlagBits2::eTransfer
+	);
+	cmdBuffer.copyBuffer(frame.count->handle(), frame.readback->handle(), vk::BufferCopy{ .size = sizeof(uint32_t) * eCounterCount });
+	CommandBuffer::GlobalBarrier(
+		cmdBuffer,
+		vk::AccessFlagBits2::eTransferWrite,
+		vk::AccessFlagBits2::eHostRead,
+		vk::PipelineStageFlagBits2::eTransfer,
+		vk::PipelineStageFlagBits2::eHost
+	);
+	frame.statsPending = true;
+}
+
+void GpuCulling::CollectStats(uint32_t frameIndex) {
+	FrameBuffers& frame = m_frames[frameIndex];
+	if (!std::exchange(frame.statsPending, false)) {
+		return;
+	}
+
+	std::array<uint32_t, eCounterCount> counters;
+	std::memcpy(counters.data(), frame.readback->Map(), sizeof(counters));
+	m_stats.frames++;
+	m_stats.firstPassDraws += counters[eFirstPassDraws];
+	m_stats.secondPassDraws += counters[eSecondPassDraws];
+	m_stats.occluded += counters[eOccluded];
+	m_stats.outsideFrustum += counters[eOutsideFrustum];
+}
+
+}
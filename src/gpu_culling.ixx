@@ -0,0 +1,126 @@
+/// @file gpu_culling.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+export module vulkan.gpuculling;
+import vulkan.buffers;
+import vulkan.depthpyramid;
+
+namespace vulkan {
+
+/// @brief Static per object input of the culling pass, indexed like the frame's object data
+export struct DrawObject {
+	glm::vec4 sphere; // local bounding sphere, xyz center and w radius
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset;
+	uint32_t padding = 0;
+};
+
+/// @brief Objects counted by the culling passes since the last ConsumeStats, read back frames later
+export struct GpuCullingStats {
+	uint64_t frames = 0;
+	uint64_t firstPassDraws = 0;  // everything drawn without occlusion, last frame's visible set with it
+	uint64_t secondPassDraws = 0; // newly visible objects, only with occlusion
+	uint64_t occluded = 0;
+	uint64_t outsideFrustum = 0;
+};
+
+/// @brief Frustum culling in a compute pass that writes indirect draws and their count
+/// @note Recording costs the same number of commands whatever the object count.
+/// With occlusion, the first pass draws what was visible last frame, its depth is reduced to a
+/// DepthPyramid and the second pass tests everything against it, drawing only what became visible
+export class GpuCulling {
+public:
+	GpuCulling(uint32_t frameCount, uint32_t maxObjects, bool occlusion = false);
+
+	/// @brief Uploads the bounds and geometry ranges of every object, in object data order
+	void SetObjects(std::span<const DrawObject> objects);
+
+	/// @brief Points the frame's culling pass at the object data it reads transforms from and the camera it projects with
+	void SetFrameBuffers(uint32_t frameIndex, vk::Buffer objectBuffer, vk::Buffer cameraBuffer);
+
+	/// @brief Points the occlusion test at a pyramid, again whenever it is recreated
+	void SetDepthPyramid(const DepthPyramid& pyramid);
+
+	/// @brief Records the culling dispatch of the first pass, has to be outside of rendering
+	void Cull(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj) const;
+
+	/// @brief Records the occlusion test of the second pass, after the pyramid was built from the first pass' depth
+	void CullOccluded(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj) const;
+
+	/// @brief Records the single indirect draw of a pass for everything that survived, inside rendering
+	void Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, uint32_t pass = 0) const;
+
+	/// @brief Copies the frame's counters where the host can read them, after the last draw
+	void ResolveStats(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex);
+
+	/// @brief Adds what a frame counted, once the GPU finished it
+	void CollectStats(uint32_t frameIndex);
+
+	GpuCullingStats ConsumeStats() { return std::exchange(m_stats, {}); }
+
+	[[nodiscard]]
+	bool occlusion() const { return m_occlusion; }
+
+private:
+	/// Counters of a frame, first pass draws come first so the draw count is read at offset 0
+	enum Counter : uint32_t {
+		eFirstPassDraws,
+		eSecondPassDraws,
+		eOccluded,
+		eOutsideFrustum,
+		eCounterCount
+	};
+
+	struct CullParams {
+		std::array<glm::vec4, 6> planes;
+		uint32_t objectCount;
+		uint32_t pass;
+		uint32_t pyramidWidth;
+		uint32_t pyramidHeight;
+		uint32_t pyramidLevels;
+		uint32_t padding[3];
+	};
+
+	struct FrameBuffers {
+		std::unique_ptr<Buffer> commands; // one list per pass, each objectCount long
+		std::unique_ptr<Buffer> count;    // every Counter
+		std::unique_ptr<Buffer> readback;
+		bool statsPending = false;
+	};
+
+	void CreatePipeline();
+	void CreateDescriptorSets(uint32_t frameCount);
+	void Dispatch(vk::raii::CommandBuffer& cmdBuffer, uint32_t frameIndex, const glm::mat4& viewProj, uint32_t pass) const;
+
+	uint32_t m_maxObjects;
+	uint32_t m_objectCount = 0;
+	bool m_occlusion;
+	std::unique_ptr<Buffer> m_drawObjects;
+	std::unique_ptr<Buffer> m_visibility; // per object, whether the last occlusion test passed
+	std::vector<FrameBuffers> m_frames;
+	vk::Extent2D m_pyramidExtent;
+	uint32_t m_pyramidLevels = 0;
+	GpuCullingStats m_stats;
+
+	vk::raii::DescriptorSetLayout m_descriptorSetLayout = nullptr;
+	vk::raii::PipelineLayout m_pipelineLayout = nullptr;
+	vk::raii::Pipeline m_pipeline = nullptr;
+	vk::raii::Pipeline m_occlusionPipeline = nullptr; // only with occlusion
+	vk::raii::DescriptorPool m_descriptorPool = nullptr;
+	vk::raii::DescriptorSets m_descriptorSets = nullptr;
+};
+
+}
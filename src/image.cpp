@@ -0,0 +1,100 @@
+/// @file image.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <array>
+#include <stdexcept>
+
+module vulkan.image;
+import vulkan.device;
+import vulkan.memory;
+
+namespace vulkan {
+
+vk::Format FindDepthFormat() {
+	constexpr std::array candidates = { vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint };
+	constexpr vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage;
+	for (vk::Format format : candidates) {
+		if ((Device::physicalDevice().getFormatProperties(format).optimalTilingFeatures & required) == required) {
+			return format;
+		}
+	}
+	throw std::runtime_error("No depth format can be rendered to and sampled");
+}
+
+vk::ImageAspectFlags FormatAspects(vk::Format format) {
+	switch (format) {
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint:
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eD16Unorm:
+	case vk::Format::eX8D24UnormPack32:
+	case vk::Format::eD32Sfloat:
+		return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eS8Uint:
+		return vk::ImageAspectFlagBits::eStencil;
+	default:
+		return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
+Image::Image(vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, uint32_t mipLevels)
+	: m_extent(extent)
+	, m_format(format)
+	, m_aspect(aspect)
+	, m_mipLevels(mipLevels)
+{
+	m_image = vk::raii::Image(Device::get(), vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = format,
+		.extent = { extent.width, extent.height, 1 },
+		.mipLevels = mipLevels,
+		.arrayLayers = 1,
+		.samples = vk::SampleCountFlagBits::e1,
+		.tiling = vk::ImageTiling::eOptimal,
+		.usage = usage,
+		.sharingMode = vk::SharingMode::eExclusive,
+		.initialLayout = vk::ImageLayout::eUndefined
+	});
+	m_allocation = MemoryAllocator::get().Allocate(m_image.getMemoryRequirements(), vk::MemoryPropertyFlagBits::eDeviceLocal, ResourceKind::eOptimal);
+	m_image.bindMemory(m_allocation.memory, m_allocation.offset);
+
+	m_view = CreateView(0, mipLevels);
+	if (mipLevels > 1) {
+		m_mipViews.reserve(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; ++level) {
+			m_mipViews.push_back(CreateView(level, 1));
+		}
+	}
+}
+
+Image::~Image() {
+	// Views and the image have to go before the memory they are bound to
+	m_mipViews.clear();
+	m_view.clear();
+	m_image.clear();
+	if (m_allocation) {
+		MemoryAllocator::get().Free(m_allocation);
+	}
+}
+
+vk::raii::ImageView Image::CreateView(uint32_t baseLevel, uint32_t levelCount) const {
+	return vk::raii::ImageView(Device::get(), vk::ImageViewCreateInfo{
+		.image = *m_image,
+		.viewType = vk::ImageViewType::e2D,
+		.format = m_format,
+		.subresourceRange = {
+			.aspectMask = m_aspect,
+			.baseMipLevel = baseLevel,
+			.levelCount = levelCount,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		}
+	});
+}
+
+}
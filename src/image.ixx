@@ -0,0 +1,63 @@
+/// @file image.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <vector>
+
+export module vulkan.image;
+import vulkan.memory;
+
+namespace vulkan {
+
+/// @brief First depth format the device can both render to and sample from
+/// @note It may carry stencil as well, see FormatAspects
+export vk::Format FindDepthFormat();
+
+/// @brief Every aspect a format has, what a layout transition of the whole image has to name
+export vk::ImageAspectFlags FormatAspects(vk::Format format);
+
+/// @brief Device local optimally tiled 2D image with a view over every mip and one view per mip
+export class Image {
+public:
+	Image(vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, uint32_t mipLevels = 1);
+	~Image();
+
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
+
+	[[nodiscard]]
+	vk::Image handle() const { return *m_image; }
+	/// @brief View over every mip level
+	[[nodiscard]]
+	vk::ImageView view() const { return *m_view; }
+	/// @brief View of a single mip level, for passes writing one level at a time
+	[[nodiscard]]
+	vk::ImageView mipView(uint32_t level) const { return m_mipViews.empty() ? *m_view : *m_mipViews[level]; }
+
+	[[nodiscard]]
+	vk::Extent2D extent() const { return m_extent; }
+	[[nodiscard]]
+	vk::Format format() const { return m_format; }
+	[[nodiscard]]
+	vk::ImageAspectFlags aspect() const { return m_aspect; }
+	[[nodiscard]]
+	uint32_t mipLevels() const { return m_mipLevels; }
+
+private:
+	vk::raii::ImageView CreateView(uint32_t baseLevel, uint32_t levelCount) const;
+
+	vk::raii::Image m_image = nullptr;
+	Allocation m_allocation;
+	vk::raii::ImageView m_view = nullptr;
+	std::vector<vk::raii::ImageView> m_mipViews;
+	vk::Extent2D m_extent;
+	vk::Format m_format;
+	vk::ImageAspectFlags m_aspect;
+	uint32_t m_mipLevels;
+};
+
+}
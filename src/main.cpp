@@ -1,15 +1,26 @@
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <mutex>
 #include <print>
+#include <format>
+#include <cstddef>
 #include <cstdlib>
 #include <atomic>
-#include <thread>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vulkan/vulkan_raii.hpp>
-#include <mutex>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/glm.hpp"
 #include "glm/gtx/transform.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 import window;
 import vulkan.instance;
@@ -18,38 +29,219 @@ import vulkan.swapchain;
 import vulkan.pipeline;
 import vulkan.commandpool;
 import vulkan.commandbuffer;
+import vulkan.commandencoder;
 import vulkan.mesh;
+import vulkan.geometry;
+import vulkan.framedata;
+import vulkan.gpuculling;
+import vulkan.depthpyramid;
+import vulkan.upload;
+import vulkan.memory;
 import thread_pool;
+import task_graph;
+import frustum_culling;
+import bvh;
+import scene_graph;
+import transform_store;
+import render_queue;
 
 float rotation = 0.0f;
 
+/// @brief How draws are spread over secondary command buffers
+enum class RecordingMode {
+	ePerMesh, ///< One secondary per object
+	eBatched, ///< One secondary per contiguous chunk of objects
+	eRetained, ///< Batched, but chunks are only re-recorded when what they draw changes
+	eGpuDriven ///< Culled on the GPU, the CPU records one indirect draw whatever the object count
+};
+
+/// @brief How the CPU decides which objects are drawn
+enum class CullingMode {
+	eNone,   ///< Everything is drawn
+	eLinear, ///< Every bounding sphere is tested, SIMD over the thread pool
+	eBvh     ///< Whole subtrees of a BVH are rejected or accepted at once
+};
+
+/// @brief Something drawn in the scene, any number of objects can share a mesh
+struct SceneObject {
+	uint32_t mesh;
+	glm::vec3 position;
+	uint32_t row; // grid row, the object's parent in the scene graph
+	bool transparent = false;
+};
+
+/// @brief Contiguous run of objects sharing geometry, drawn as one instanced call
+struct DrawGroup {
+	uint32_t mesh; // any of the group's meshes, they all bind the same buffers
+	uint32_t firstObject;
+	uint32_t objectCount;
+	bool transparent; // groups never mix opaque and transparent objects
+};
+
 class HelloTriangleApplication {
 public:
 	void run() {
+		if (m_sortBenchmarkKeys > 0) {
+			RunSortBenchmark();
+			return;
+		}
 		initVulkan();
 		mainLoop();
 	}
 
+	/// @brief Reads "--grid <width> <height>", "--recording <per-mesh|batched|retained|gpu> [chunks]", "--no-instancing"
+	/// "--mesh-per-object", "--culling <none|linear|bvh>", "--animated <percent>", "--occlusion",
+	/// "--transparent <percent>", "--overdraw", "--benchmark-sort [keys]" and "--frames-in-flight <1-3>"
+	void ParseArguments(int argc, char** argv) {
+		for (int i = 1; i < argc; ++i) {
+			std::string_view arg = argv[i];
+			if (arg == "--grid" && i + 2 < argc) {
+				m_gridWidth = std::max(1, std::atoi(argv[++i]));
+				m_gridHeight = std::max(1, std::atoi(argv[++i]));
+			} else if (arg == "--recording" && i + 1 < argc) {
+				std::string_view mode = argv[++i];
+				m_recordingMode = mode == "batched" ? RecordingMode::eBatched
+					: mode == "retained" ? RecordingMode::eRetained
+					: mode == "gpu" ? RecordingMode::eGpuDriven
+					: RecordingMode::ePerMesh;
+				if (i + 1 < argc && argv[i + 1][0] != '-') {
+					m_batchCount = static_cast<size_t>(std::atoi(argv[++i]));
+				}
+			} else if (arg == "--no-instancing") {
+				m_instancing = false;
+			} else if (arg == "--mesh-per-object") {
+				m_meshPerObject = true;
+			} else if (arg == "--culling" && i + 1 < argc) {
+				std::string_view mode = argv[++i];
+				m_culling = mode == "none" ? CullingMode::eNone
+					: mode == "bvh" ? CullingMode::eBvh
+					: CullingMode::eLinear;
+			} else if (arg == "--animated" && i + 1 < argc) {
+				m_animatedPercent = std::clamp(std::atoi(argv[++i]), 0, 100);
+			} else if (arg == "--occlusion") {
+				m_occlusion = true;
+			} else if (arg == "--transparent" && i + 1 < argc) {
+				m_transparentPercent = std::clamp(std::atoi(argv[++i]), 0, 100);
+			} else if (arg == "--overdraw") {
+				m_overdraw = true;
+			} else if (arg == "--frames-in-flight" && i + 1 < argc) {
+				m_framesInFlight = static_cast<uint32_t>(std::clamp(std::atoi(argv[++i]), 1, static_cast<int>(MAX_FRAMES_IN_FLIGHT)));
+			} else if (arg == "--benchmark-sort") {
+				m_sortBenchmarkKeys = 1'000'000;
+				if (i + 1 < argc && argv[i + 1][0] != '-') {
+					m_sortBenchmarkKeys = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+				}
+			} else {
+				std::println("Ignoring unknown argument \"{}\"", arg);
+			}
+		}
+	}
+
 private:
 	std::unique_ptr<vulkan::Instance> m_instance;
 	std::unique_ptr<Window> m_window;
 	std::unique_ptr<vulkan::Device> m_device;
+	std::unique_ptr<vulkan::MemoryAllocator> m_memory;
+	std::unique_ptr<vulkan::UploadManager> m_uploads;
+	std::unique_ptr<vulkan::GeometryRegistry> m_geometry;
+	uint64_t m_geometryGeneration = 0; // arena layout everything recorded and uploaded so far was built against
 	std::unique_ptr<vulkan::Swapchain> m_swapchain;
-	std::unique_ptr<vulkan::Pipeline> m_pipeline;
+	std::unique_ptr<vulkan::Pipeline> m_pipeline;            // opaque, owns the layout both pipelines use
+	std::unique_ptr<vulkan::Pipeline> m_transparentPipeline;
+	int m_transparentPercent = 0;
+	bool m_overdraw = false;                                 // both pipelines show fragments per pixel instead of shading
 	// std::unique_ptr<vulkan::Mesh> m_mesh;
 	std::vector<std::unique_ptr<vulkan::Mesh>> m_meshes;
+	std::vector<SceneObject> m_objects; // sorted by geometry, index is the object's entry in the frame data
+	std::vector<DrawGroup> m_drawGroups;
+	std::vector<uint32_t> m_objectGroups; // draw group of every object, the geometry field of its sort key
+	bool m_instancing = true;           // one draw per group instead of one per object
+	bool m_meshPerObject = false;       // build a Mesh for every object, geometry is still shared by content
+	std::unique_ptr<vulkan::FrameData> m_frameData; // object data of every object, one buffer per frame
+	std::unique_ptr<vulkan::GpuCulling> m_gpuCulling; // only in GPU driven mode
+	std::unique_ptr<vulkan::DepthPyramid> m_depthPyramid; // only with occlusion culling
+	bool m_occlusion = false;                         // two pass Hi-Z occlusion culling, GPU driven mode only
+
+	// Frustum culling on the CPU, the frame data is packed with visible objects only
+	CullingMode m_culling = CullingMode::eLinear;
+	toast::FrustumCuller m_culler;
+	toast::Bvh m_bvh;                       // built on the first frame, refit when objects move
+	std::vector<glm::vec4> m_objectSpheres; // world space bounds, xyz center and w radius
+	std::vector<uint32_t> m_allObjects;     // every object index, what is drawn without culling
+	std::vector<uint32_t> m_lastVisible;    // the render queue is rebuilt and retained mode re-records when this changes
+	toast::RenderQueue m_renderQueue;       // m_lastVisible sorted by state then depth, transparent ones by depth first
+	std::vector<toast::RenderRun> m_recordedRuns; // runs of the previous render queue, retained chunks drew these
+	glm::mat4 m_sortedView{0.0f};           // camera the render queue was sorted for
+	bool m_drawOrderStale = true;           // set when an object's bounds moved
+	std::span<const uint32_t> m_visible;    // object of every frame data slot, in render queue order
+	size_t m_sortBenchmarkKeys = 0;         // sort this many random keys and exit instead of rendering
+	size_t m_chunkCount = 0;                // graph chunks, each takes an even share of the visible slots
+
+	// Binding everything per draw takes pipeline, descriptor set, vertex and index buffer, viewport and scissor,
+	// what the render queue and the command encoder save is counted against that
+	static constexpr uint64_t DRAW_STATE_COMMANDS = 6;
+
+	// Grid rows and their objects as a hierarchy, only what changed is written to the frame data
+	static constexpr uint32_t NO_OBJECT = ~0u;
+	static_assert(NO_OBJECT == toast::MatrixMirror::NO_SLOT, "Grouping nodes are skipped when mirroring world matrices");
+	toast::SceneGraph m_scene;
+	std::vector<toast::SceneGraph::NodeId> m_objectNodes;
+	std::vector<uint32_t> m_nodeObjects;                  // NO_OBJECT for nodes only grouping others
+	std::vector<uint32_t> m_animatedObjects;
+	int m_animatedPercent = 100;
+	std::vector<std::vector<uint32_t>> m_changedObjects;  // per frame slot, changed while building it
+	std::vector<uint32_t> m_pendingWrites;                // stale entries of the current frame's object data
+	std::vector<uint32_t> m_writeStamps;
+	uint32_t m_writeStamp = 0;
+	std::vector<uint8_t> m_instancesWritten;              // per frame slot, cleared whenever the draw order changes
 
-	std::vector<vulkan::CommandBuffer> m_commandBuffers;
-	std::vector<std::vector<vulkan::CommandBuffer>> m_secondaryCommandBuffers;
-	std::vector<vk::raii::Semaphore> m_presentCompleteSemaphores;
-	std::vector<vk::raii::Semaphore> m_renderFinishedSemaphores;
-	std::vector<vk::raii::Fence> m_drawFences;
+	// Command buffers of the frame being built, owned by the per-thread frame pools
+	vulkan::CommandBuffer* m_primaryCommandBuffer = nullptr;
+	std::vector<vk::CommandBuffer> m_secondaryHandles;
+	// Frames the CPU may build ahead of the GPU, independent of how many images the swapchain has.
+	// Every per-frame resource has this many copies, m_currentFrame picks the one of the frame being built
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+	uint32_t m_framesInFlight = 2;
 	uint32_t m_currentFrame = 0;
+	std::vector<vk::raii::Semaphore> m_presentCompleteSemaphores; // per frame in flight, signaled by the acquire
+	std::vector<vk::raii::Semaphore> m_renderFinishedSemaphores;  // per swapchain image, waited on by its present
+	// Submit N signals value N, so the counter is the number of frames the GPU has finished
+	vk::raii::Semaphore m_frameTimeline = nullptr;
+	uint64_t m_submittedFrames = 0;
 
 	toast::ThreadPool m_threadPool;
 	bool m_framebufferResized = false;
 
-	// Grid layout for meshes
+	// Frame work as a dependency graph, rebuilt only when the mesh set changes
+	toast::TaskGraph m_frameGraph;
+	RecordingMode m_recordingMode = RecordingMode::ePerMesh;
+	size_t m_graphChunkSize = 4; // objects per graph node in per-mesh mode
+	size_t m_batchCount = 0;     // secondaries in batched mode, 0 means one per thread
+
+	// Retained mode: one cached secondary per frame slot and chunk, valid while its chunk version matches
+	std::vector<std::vector<std::unique_ptr<vulkan::RetainedCommandBuffer>>> m_retainedSecondaries;
+	std::vector<uint64_t> m_chunkVersions;
+	uint64_t m_recordingVersion = 0;
+	std::atomic<uint32_t> m_rerecordedChunks = 0;
+	uint64_t m_frameNumber = 0;
+	uint64_t m_profileInterval = 600; // frames between profiling dumps
+
+	// State of the frame being built, read by the graph nodes
+	uint32_t m_imageIndex = 0;
+	glm::quat m_frameSpin = glm::identity<glm::quat>();
+
+	// CPU cost counters, reset every profiling dump
+	std::atomic<int64_t> m_recordTime = 0; // ns spent recording secondaries, summed over threads
+	std::atomic<uint64_t> m_drawsRecorded = 0;
+	std::atomic<uint64_t> m_stateCommandsIssued = 0; // binds and dynamic state secondaries recorded along with those draws
+	std::array<std::atomic<uint64_t>, vulkan::ENCODER_COMMAND_COUNT> m_encoderIssued{}; // every buffer, by command
+	std::array<std::atomic<uint64_t>, vulkan::ENCODER_COMMAND_COUNT> m_encoderElided{};
+	int64_t m_submitTime = 0;              // ns spent inside vkQueueSubmit
+	int64_t m_sceneTime = 0;               // ns spent updating the scene graph
+	uint64_t m_changedNodes = 0;
+	uint64_t m_objectWrites = 0;           // object data entries rewritten
+
+	// Grid layout for objects
 	int m_gridWidth = 5;
 	int m_gridHeight = 5;
 	float m_gridSpacing = 2.0f;
@@ -62,155 +254,658 @@ private:
 		m_instance = std::make_unique<vulkan::Instance>();
 		m_window->CreateSurface();
 		m_device = std::make_unique<vulkan::Device>();
+		m_memory = std::make_unique<vulkan::MemoryAllocator>();
+		m_uploads = std::make_unique<vulkan::UploadManager>();
+		m_geometry = std::make_unique<vulkan::GeometryRegistry>(sizeof(vulkan::Vertex));
 		m_swapchain = std::make_unique<vulkan::Swapchain>();
-		m_pipeline = std::make_unique<vulkan::Pipeline>(); // pipeline now owns descriptor set layout
+		m_pipeline = std::make_unique<vulkan::Pipeline>(vulkan::PipelineVariant::eOpaque, m_overdraw); // pipeline now owns descriptor set layout
+		m_transparentPipeline = std::make_unique<vulkan::Pipeline>(m_pipeline->GetPipelineLayout(), vulkan::PipelineVariant::eTransparent, m_overdraw);
+		if (m_overdraw) {
+			std::println("Overdraw view: every fragment passing the depth test brightens its pixel by the same step");
+		}
+		if (m_transparentPercent > 0 && m_recordingMode == RecordingMode::eGpuDriven) {
+			std::println("GPU driven mode draws every object opaque, ignoring --transparent");
+			m_transparentPercent = 0;
+		}
 		CreateMesh();
-		// init mesh descriptors using pipeline's descriptor set layout and frame count
-		for (auto& mesh : m_meshes) {
-			mesh->InitDescriptors(m_pipeline->GetDescriptorSetLayout(), static_cast<uint32_t>(m_swapchain->get().getImages().size()));
+		m_frameData = std::make_unique<vulkan::FrameData>(m_pipeline->GetDescriptorSetLayout(),
+			m_framesInFlight, static_cast<uint32_t>(m_objects.size()));
+		if (m_occlusion && m_recordingMode != RecordingMode::eGpuDriven) {
+			std::println("Occlusion culling needs --recording gpu, turning it off");
+			m_occlusion = false;
 		}
+		if (m_recordingMode == RecordingMode::eGpuDriven) {
+			CreateGpuCulling();
+		}
+		CreateDepthPyramid();
 		CreateSyncObjects();
-		CreateCommandBuffers();
-		m_threadPool.Init(4);
+		m_threadPool.Init(4); // the scene sorts its first render queue on it
+		CreateScene();
+		BuildFrameGraph();
+		m_memory->DumpStats();
 	}
 
 	void CreateSyncObjects() {
-		uint32_t imageCount = static_cast<uint32_t>(m_swapchain->get().getImages().size());
-		m_presentCompleteSemaphores.reserve(imageCount);
-		m_renderFinishedSemaphores.reserve(imageCount);
-		m_drawFences.reserve(imageCount);
-		m_secondaryCommandBuffers.resize(imageCount);
-		
-		for (uint32_t i = 0; i < imageCount; ++i) {
+		m_presentCompleteSemaphores.clear();
+		m_presentCompleteSemaphores.reserve(m_framesInFlight);
+		for (uint32_t i = 0; i < m_framesInFlight; ++i) {
 			m_presentCompleteSemaphores.emplace_back(m_device->get(), vk::SemaphoreCreateInfo());
+		}
+		CreateRenderFinishedSemaphores();
+
+		vk::SemaphoreTypeCreateInfo timelineInfo{
+			.semaphoreType = vk::SemaphoreType::eTimeline,
+			.initialValue = 0
+		};
+		m_frameTimeline = vk::raii::Semaphore(m_device->get(), vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
+		m_submittedFrames = 0;
+		std::println("{} frames in flight over {} swapchain images", m_framesInFlight, vulkan::Swapchain::imageCount());
+	}
+
+	/// @brief One per swapchain image, a present may still wait on its semaphore until the image is acquired again
+	/// @note The device has to be idle, again whenever the swapchain is recreated
+	void CreateRenderFinishedSemaphores() {
+		m_renderFinishedSemaphores.clear();
+		m_renderFinishedSemaphores.reserve(vulkan::Swapchain::imageCount());
+		for (uint32_t i = 0; i < vulkan::Swapchain::imageCount(); ++i) {
 			m_renderFinishedSemaphores.emplace_back(m_device->get(), vk::SemaphoreCreateInfo());
-			m_drawFences.emplace_back(m_device->get(), vk::FenceCreateInfo{ .flags = vk::FenceCreateFlagBits::eSignaled });
 		}
 	}
 
+	/// @brief Frames the GPU has finished, frame N's work is done once this reaches N
+	[[nodiscard]]
+	uint64_t CompletedFrames() const {
+		return m_frameTimeline.getCounterValue();
+	}
+
+	/// @brief Blocks until the GPU finished the first frameCount frames
+	void WaitForFrame(uint64_t frameCount) const {
+		vk::Semaphore timeline = *m_frameTimeline;
+		vk::SemaphoreWaitInfo waitInfo{
+			.semaphoreCount = 1,
+			.pSemaphores = &timeline,
+			.pValues = &frameCount
+		};
+		[[maybe_unused]] auto result = m_device->get().waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max());
+	}
+
 	void CreateMesh() {
-		m_meshes.clear();
-		int total = m_gridWidth * m_gridHeight;
-		m_meshes.reserve(total);
-		for (int y = 0; y < m_gridHeight; ++y) {
-			for (int x = 0; x < m_gridWidth; ++x) {
-				m_meshes.emplace_back(std::make_unique<vulkan::Mesh>(vulkan::Mesh::CreateCube()));
+		// Centered grid of cubes
+		float startX = -((m_gridWidth - 1) * 0.5f * m_gridSpacing);
+		float startZ = -((m_gridHeight - 1) * 0.5f * m_gridSpacing);
+		m_objects.clear();
+		m_objects.reserve(static_cast<size_t>(m_gridWidth) * m_gridHeight);
+		for (int row = 0; row < m_gridHeight; ++row) {
+			for (int col = 0; col < m_gridWidth; ++col) {
+				// Stepping by a number coprime to 100 spreads transparent objects over the whole grid
+				size_t index = m_objects.size();
+				m_objects.push_back(SceneObject{
+					.mesh = m_meshPerObject ? static_cast<uint32_t>(index) : 0,
+					.position = glm::vec3(startX + col * m_gridSpacing, 0.0f, startZ + row * m_gridSpacing),
+					.row = static_cast<uint32_t>(row),
+					.transparent = static_cast<int>(index * 37 % 100) < m_transparentPercent
+				});
 			}
 		}
+
+		auto loadStart = std::chrono::steady_clock::now();
+		m_meshes.clear();
+		size_t meshCount = m_meshPerObject ? m_objects.size() : 1;
+		m_meshes.reserve(meshCount);
+		for (size_t i = 0; i < meshCount; ++i) {
+			m_meshes.emplace_back(std::make_unique<vulkan::Mesh>(vulkan::Mesh::CreateCube()));
+		}
+		auto enqueueEnd = std::chrono::steady_clock::now();
+
+		// Frames wait on the upload timeline themselves, this only measures how long the batch takes
+		vulkan::UploadTicket ticket = m_uploads->Flush();
+		m_uploads->Wait(ticket);
+		auto loadEnd = std::chrono::steady_clock::now();
+
+		std::println("Loaded {} meshes: {:.3f} ms enqueue, {:.3f} ms until uploaded, {} upload batches",
+			m_meshes.size(), std::chrono::duration<double, std::milli>(enqueueEnd - loadStart).count(),
+			std::chrono::duration<double, std::milli>(loadEnd - loadStart).count(), ticket);
+		m_geometry->DumpStats();
+
+		BuildDrawGroups();
 	}
 
-	void CreateCommandBuffers() {
-		auto& pool = vulkan::CommandPool::GetForCurrentThread();
-		uint32_t imageCount = static_cast<uint32_t>(m_swapchain->get().getImages().size());
-		m_commandBuffers = pool.AllocateBuffers(imageCount);
+	/// @brief Sorts objects by geometry so every distinct geometry's objects are one instance range
+	/// @note Opaque objects come first, so every transparent one is drawn over a finished opaque scene
+	void BuildDrawGroups() {
+		auto groupOf = [this](const SceneObject& object) { return std::pair(object.transparent, m_meshes[object.mesh]->GetGeometryId()); };
+		std::ranges::stable_sort(m_objects, {}, groupOf);
+
+		m_drawGroups.clear();
+		m_objectGroups.resize(m_objects.size());
+		for (uint32_t i = 0; i < m_objects.size(); ++i) {
+			const SceneObject& object = m_objects[i];
+			if (m_drawGroups.empty() || groupOf(m_objects[m_drawGroups.back().firstObject]) != groupOf(object)) {
+				m_drawGroups.push_back(DrawGroup{ .mesh = object.mesh, .firstObject = i, .objectCount = 0, .transparent = object.transparent });
+			}
+			m_drawGroups.back().objectCount++;
+			m_objectGroups[i] = static_cast<uint32_t>(m_drawGroups.size() - 1);
+		}
+		if (m_drawGroups.size() > uint64_t{1} << toast::SortKey::GEOMETRY_BITS) {
+			throw std::runtime_error(std::format("{} draw groups do not fit the geometry field of a sort key", m_drawGroups.size()));
+		}
+		size_t transparentCount = std::ranges::count_if(m_objects, &SceneObject::transparent);
+		std::println("{} objects ({} transparent) in {} draw groups", m_objects.size(), transparentCount, m_drawGroups.size());
 	}
 
-	void drawFrame() {
-		[[maybe_unused]] auto waitResult = m_device->get().waitForFences(*m_drawFences[m_currentFrame], vk::True, std::numeric_limits<uint64_t>::max());
-		
-		// Clear previous frame's secondary buffers now that fence has signaled
-		m_secondaryCommandBuffers[m_currentFrame].clear();
-		
-		auto [result, image_index] = m_swapchain->get().acquireNextImage(std::numeric_limits<uint64_t>::max(), *m_presentCompleteSemaphores[m_currentFrame], nullptr);
+	/// @brief Hands bounds and geometry ranges of every object to the culling pass, in object data order
+	void CreateGpuCulling() {
+		uint32_t frameCount = m_framesInFlight;
+		m_gpuCulling = std::make_unique<vulkan::GpuCulling>(frameCount, static_cast<uint32_t>(m_objects.size()), m_occlusion);
+		UploadDrawObjects();
 
-		if (result == vk::Result::eErrorOutOfDateKHR) {
-			recreateSwapChain();
-			return;
+		for (uint32_t frame = 0; frame < frameCount; ++frame) {
+			m_gpuCulling->SetFrameBuffers(frame, m_frameData->objectBuffer(frame), m_frameData->cameraBuffer(frame));
 		}
-		if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
-			throw std::runtime_error("failed to acquire swap chain image!");
+	}
+
+	/// @brief Bounds and arena offsets of every object for the culling pass, again whenever the arena is compacted
+	void UploadDrawObjects() {
+		std::vector<vulkan::DrawObject> drawObjects;
+		drawObjects.reserve(m_objects.size());
+		for (const SceneObject& object : m_objects) {
+			const vulkan::Mesh& mesh = *m_meshes[object.mesh];
+			drawObjects.push_back(vulkan::DrawObject{
+				.sphere = mesh.GetBoundingSphere(),
+				.firstIndex = mesh.GetFirstIndex(),
+				.indexCount = mesh.GetIndexCount(),
+				.vertexOffset = mesh.GetVertexOffset()
+			});
 		}
+		m_gpuCulling->SetObjects(drawObjects);
+		m_uploads->Flush(); // the next frame's submit waits on it
+		m_geometryGeneration = m_geometry->generation();
+	}
 
-		m_device->get().resetFences(*m_drawFences[m_currentFrame]);
+	/// @brief Compaction moved geometry to new buffers and offsets, everything recorded or uploaded with the old ones is stale
+	void OnGeometryMoved() {
+		m_geometryGeneration = m_geometry->generation();
+		InvalidateRecording();
+		if (m_gpuCulling) {
+			// Frames submitted since may still read the draw objects about to be overwritten
+			WaitForFrame(m_submittedFrames);
+			UploadDrawObjects();
+		}
+	}
 
-		// Update uniform buffers
-		rotation += 1.f * 0.166f;
-		float angle = glm::radians(rotation);
-		
-		// Compute centered grid origin
-		float startX = -((m_gridWidth - 1) * 0.5f * m_gridSpacing);
+	/// @brief Pyramid of the swapchain's depth buffer, again whenever the swapchain is recreated
+	void CreateDepthPyramid() {
+		if (m_occlusion) {
+			m_depthPyramid = std::make_unique<vulkan::DepthPyramid>(vulkan::Swapchain::depthImage());
+			m_gpuCulling->SetDepthPyramid(*m_depthPyramid);
+		}
+	}
+
+	/// @brief One node per grid row with its objects below, every node starts out changed
+	void CreateScene() {
+		m_scene.Clear();
+		m_nodeObjects.clear();
+		std::vector<toast::SceneGraph::NodeId> rowNodes(m_gridHeight);
 		float startZ = -((m_gridHeight - 1) * 0.5f * m_gridSpacing);
+		for (int row = 0; row < m_gridHeight; ++row) {
+			rowNodes[row] = m_scene.AddNode();
+			m_scene.SetPosition(rowNodes[row], glm::vec3(0.0f, 0.0f, startZ + row * m_gridSpacing));
+			m_nodeObjects.push_back(NO_OBJECT);
+		}
+
+		m_objectNodes.resize(m_objects.size());
+		m_animatedObjects.clear();
+		for (uint32_t i = 0; i < m_objects.size(); ++i) {
+			const SceneObject& object = m_objects[i];
+			m_objectNodes[i] = m_scene.AddNode(rowNodes[object.row]);
+			m_scene.SetPosition(m_objectNodes[i], glm::vec3(object.position.x, object.position.y, 0.0f));
+			m_nodeObjects.push_back(i);
+			if (static_cast<int>(i * 100 / m_objects.size()) < m_animatedPercent) {
+				m_animatedObjects.push_back(i);
+			}
+		}
 
-		for (size_t i = 0; i < m_meshes.size(); ++i) {
-			vulkan::UniformBufferObject ubo{};
+		m_changedObjects.assign(m_framesInFlight, {});
+		m_writeStamps.assign(m_objects.size(), 0);
+		m_writeStamp = 0;
+		m_instancesWritten.assign(m_framesInFlight, 0);
 
-			int col = static_cast<int>(i) % m_gridWidth;
-			int row = static_cast<int>(i) / m_gridWidth;
-			glm::vec3 position(startX + col * m_gridSpacing, 0.0f, startZ + row * m_gridSpacing);
+		// Bounds follow the scene, GPU driven mode culls on its own
+		m_allObjects.resize(m_objects.size());
+		std::iota(m_allObjects.begin(), m_allObjects.end(), 0u);
+		if (m_recordingMode == RecordingMode::eGpuDriven) {
+			m_culling = CullingMode::eNone;
+		}
+		m_culler.Resize(m_objects.size());
+		m_objectSpheres.assign(m_objects.size(), glm::vec4(0.0f));
+		m_lastVisible.clear();
+		m_drawOrderStale = true;
 
-			ubo.model = glm::translate(glm::mat4(1.0f), position)
-				* glm::rotate(glm::mat4(1.0f), angle, glm::vec3(1.0f, 0.0f, 1.0f));
-			ubo.view = glm::lookAt(
-				glm::vec3(0.0f, 15.0f, 0.0f),
-				glm::vec3(0.0f, 0.0f, 0.0f),
-				glm::vec3(0.0f, 0.0f, 1.0f)
-			);
-			auto extent = vulkan::Swapchain::extent();
-			float aspectRatio = extent.width / (float)extent.height;
-			ubo.proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
-			ubo.proj[1][1] *= -1;
-			m_meshes[i]->UpdateUniformBuffer(m_currentFrame, ubo);
-		}
-
-		// Record secondary command buffers in parallel (one per thread per mesh)
-		std::atomic<size_t> completedCount{0};
-		std::vector<vulkan::CommandBuffer> secondaryBuffers;
-		secondaryBuffers.reserve(m_meshes.size());
-		std::mutex buffersMutex;
-		
-		for (size_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex) {
-			m_threadPool.QueueJob([this, meshIndex, &completedCount, &secondaryBuffers, &buffersMutex]() {
-				// Each thread gets its own command pool
-				auto& threadPool = vulkan::CommandPool::GetForCurrentThread();
-				
-				// Allocate a new secondary command buffer for this mesh on this thread
-				auto secondaryCmd = threadPool.AllocateBuffer(vk::CommandBufferLevel::eSecondary);
-				
-				// Inheritance info for secondary command buffer
-				vk::Format swapchainFormat = vulkan::Swapchain::format();
-				vk::CommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{
-					.colorAttachmentCount = 1,
-					.pColorAttachmentFormats = &swapchainFormat,
-					.rasterizationSamples = vk::SampleCountFlagBits::e1
-				};
-
-				vk::CommandBufferInheritanceInfo inheritanceInfo{
-					.pNext = &inheritanceRenderingInfo
-				};
-
-				auto flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue;
-				
-				secondaryCmd.Record([&](vk::raii::CommandBuffer& cmd) {
-					// Bind pipeline and set viewport/scissor
-					cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
-					auto extent = vulkan::Swapchain::extent();
-					cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
-					cmd.setScissor(0, vk::Rect2D({0, 0}, extent));
-
-					// Draw this mesh
-					m_meshes[meshIndex]->BindAndDraw(cmd, m_pipeline->GetPipelineLayout(), m_currentFrame);
-				}, flags, &inheritanceInfo);
-
-				{
-					std::lock_guard<std::mutex> lock(buffersMutex);
-					secondaryBuffers.push_back(std::move(secondaryCmd));
+		// Every object with no bounds yet, so the frame graph sees the draws of an unculled frame
+		BuildRenderQueue(m_allObjects, glm::mat4(1.0f));
+		m_recordedRuns.clear();
+	}
+
+	/// @brief Animates the scene and collects the object entries this frame's buffer misses
+	void UpdateScene() {
+		auto updateStart = std::chrono::steady_clock::now();
+
+		for (uint32_t object : m_animatedObjects) {
+			m_scene.SetRotation(m_objectNodes[object], m_frameSpin);
+		}
+		// Object nodes are written straight into this frame's object data as their world matrix is built
+		toast::MatrixMirror objectData{
+			.base = reinterpret_cast<std::byte*>(&m_frameData->objects(m_currentFrame).data()->model),
+			.stride = sizeof(vulkan::ObjectData),
+			.slots = m_nodeObjects.data()
+		};
+		auto changedNodes = m_scene.Update(m_threadPool, objectData);
+
+		auto& changed = m_changedObjects[m_currentFrame];
+		changed.clear();
+		for (toast::SceneGraph::NodeId node : changedNodes) {
+			uint32_t object = m_nodeObjects[node];
+			if (object == NO_OBJECT) {
+				continue;
+			}
+			changed.push_back(object);
+
+			const glm::mat4& world = m_scene.world(node);
+			glm::vec4 sphere = m_meshes[m_objects[object].mesh]->GetBoundingSphere();
+			float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+			glm::vec4 worldSphere(glm::vec3(world * glm::vec4(glm::vec3(sphere), 1.0f)), sphere.w * scale);
+			if (glm::vec3(worldSphere) != glm::vec3(m_objectSpheres[object])) {
+				m_drawOrderStale = true;
+			}
+			m_objectSpheres[object] = worldSphere;
+			if (m_culling == CullingMode::eLinear) {
+				m_culler.SetSphere(object, glm::vec3(worldSphere), worldSphere.w);
+			} else if (m_culling == CullingMode::eBvh && m_bvh.size() == m_objects.size()) {
+				m_bvh.SetSphere(object, worldSphere);
+			}
+		}
+
+		// Every object has bounds after the first update, later ones only fix the nodes above what moved
+		if (m_culling == CullingMode::eBvh) {
+			if (m_bvh.size() != m_objects.size()) {
+				m_bvh.Build(m_threadPool, m_objectSpheres);
+			} else {
+				m_bvh.Refit();
+			}
+		}
+
+		// This frame's changes are in already. Every other slot was built once since this one,
+		// so their changes are what this buffer still misses
+		m_pendingWrites.clear();
+		++m_writeStamp;
+		for (uint32_t object : changed) {
+			m_writeStamps[object] = m_writeStamp;
+		}
+		for (const auto& frameChanges : m_changedObjects) {
+			for (uint32_t object : frameChanges) {
+				if (m_writeStamps[object] != m_writeStamp) {
+					m_writeStamps[object] = m_writeStamp;
+					m_pendingWrites.push_back(object);
+				}
+			}
+		}
+
+		m_sceneTime += (std::chrono::steady_clock::now() - updateStart).count();
+		m_changedNodes += changedNodes.size();
+		m_objectWrites += changed.size() + m_pendingWrites.size();
+	}
+
+	/// @brief Decides which objects take an instance slot this frame and in which order they are drawn
+	void CullObjects() {
+		const vulkan::CameraData& camera = m_frameData->camera(m_currentFrame);
+		std::span<const uint32_t> visible = m_allObjects;
+		if (m_culling != CullingMode::eNone) {
+			auto planes = toast::ExtractFrustumPlanes(camera.viewProj);
+			visible = m_culling == CullingMode::eBvh ? m_bvh.Cull(planes) : m_culler.Cull(m_threadPool, planes);
+		}
+
+		// The order only depends on the visible set, the camera and where objects are, all usually unchanged
+		bool visibleChanged = !std::ranges::equal(visible, m_lastVisible);
+		if (visibleChanged || m_drawOrderStale || camera.view != m_sortedView) {
+			m_lastVisible.assign(visible.begin(), visible.end());
+			BuildRenderQueue(m_lastVisible, camera.view);
+
+			// Cached chunks draw slot ranges, which mean other objects once the visible set changes. Reordering
+			// opaque objects keeps their group's range, transparent runs follow the depth order and regroup
+			if (m_recordingMode == RecordingMode::eRetained && (visibleChanged || RunsChanged())) {
+				InvalidateRecording();
+			}
+			m_recordedRuns.assign(m_renderQueue.runs().begin(), m_renderQueue.runs().end());
+			m_sortedView = camera.view;
+			m_drawOrderStale = false;
+			std::ranges::fill(m_instancesWritten, 0);
+		}
+
+		if (!m_instancesWritten[m_currentFrame]) {
+			std::ranges::copy(m_visible, m_frameData->instances(m_currentFrame).begin());
+			m_instancesWritten[m_currentFrame] = 1;
+		}
+
+		if (m_recordingMode == RecordingMode::ePerMesh) {
+			m_secondaryHandles.resize(m_visible.size());
+		}
+	}
+
+	/// @brief Sorts objects by their sort keys into the draw order, which m_visible then points to
+	/// @note Opaque objects go front to back so early depth tests reject what is hidden, their state fields come
+	/// first, so every group keeps its slot range and draws only change with the visible set. Transparent ones go
+	/// back to front across every group so they blend correctly, only neighbours sharing geometry are instanced
+	void BuildRenderQueue(std::span<const uint32_t> objects, const glm::mat4& view) {
+		// The culling pass draws slots as object indices, equal depths keep them in order
+		bool depthSorted = m_recordingMode != RecordingMode::eGpuDriven;
+		glm::vec4 depthRow(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+
+		m_renderQueue.Resize(objects.size());
+		auto keys = m_renderQueue.keys();
+		auto values = m_renderQueue.values();
+		m_threadPool.ParallelFor(objects.size(), 4096, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				uint32_t object = objects[i];
+				bool transparent = m_objects[object].transparent;
+				uint32_t depth = 0;
+				if (depthSorted) {
+					depth = toast::SortKey::DepthBits(glm::dot(depthRow, glm::vec4(glm::vec3(m_objectSpheres[object]), 1.0f)));
+					depth = transparent ? ~depth : depth;
+				}
+				auto variant = transparent ? vulkan::PipelineVariant::eTransparent : vulkan::PipelineVariant::eOpaque;
+				// No materials yet, every object shades the same
+				keys[i] = toast::SortKey::Pack(transparent ? toast::SortKey::DEPTH_FIRST_PASS : 0, static_cast<uint32_t>(variant), m_objectGroups[object], 0, depth);
+				values[i] = object;
+			}
+		});
+		m_renderQueue.Sort(m_threadPool);
+		m_visible = m_renderQueue.values();
+	}
+
+	/// @brief True when the render queue split into other runs than the ones retained chunks recorded
+	[[nodiscard]]
+	bool RunsChanged() const {
+		return !std::ranges::equal(m_renderQueue.runs(), m_recordedRuns, [](const toast::RenderRun& a, const toast::RenderRun& b) {
+			return a.first == b.first && a.count == b.count && toast::SortKey::State(a.key) == toast::SortKey::State(b.key);
+		});
+	}
+
+	/// @brief Even share [begin, end) of count items handled by a graph chunk
+	[[nodiscard]]
+	std::pair<size_t, size_t> ChunkRange(size_t chunk, size_t count) const {
+		return { chunk * count / m_chunkCount, (chunk + 1) * count / m_chunkCount };
+	}
+
+	/// @brief Calls func(mesh, pipeline, firstSlot, count) for every draw needed by visible slots [begin, end)
+	template<typename Func>
+	void ForEachDraw(size_t begin, size_t end, Func&& func) const {
+		// Runs share pipeline and geometry, those cut by the range boundaries are drawn partially, once per chunk they overlap
+		auto runs = m_renderQueue.runs();
+		auto run = std::ranges::upper_bound(runs, begin, {}, [](const toast::RenderRun& entry) { return size_t{entry.first} + entry.count; });
+		for (; run != runs.end() && run->first < end; ++run) {
+			size_t first = std::max<size_t>(run->first, begin);
+			size_t last = std::min<size_t>(size_t{run->first} + run->count, end);
+			uint32_t pipeline = toast::SortKey::Pipeline(run->key);
+			if (!m_instancing) {
+				for (size_t slot = first; slot < last; ++slot) {
+					func(m_objects[m_visible[slot]].mesh, pipeline, static_cast<uint32_t>(slot), 1u);
+				}
+				continue;
+			}
+			func(m_drawGroups[toast::SortKey::Geometry(run->key)].mesh, pipeline, static_cast<uint32_t>(first), static_cast<uint32_t>(last - first));
+		}
+	}
+
+	[[nodiscard]]
+	const vulkan::Pipeline& GetPipeline(uint32_t variant) const {
+		return static_cast<vulkan::PipelineVariant>(variant) == vulkan::PipelineVariant::eTransparent ? *m_transparentPipeline : *m_pipeline;
+	}
+
+	/// @brief Draws slots [begin, end) in queue order, each draw binding the pipeline and geometry of its key
+	/// @note Queue order puts draws sharing them next to each other, the encoder drops every bind that repeats
+	/// the previous draw's. Geometry binds always repeat, every mesh lives in the arena BindDrawState bound
+	void DrawObjects(vulkan::CommandEncoder& encoder, size_t begin, size_t end) {
+		uint64_t draws = 0;
+		ForEachDraw(begin, end, [&](uint32_t mesh, uint32_t pipeline, uint32_t firstObject, uint32_t count) {
+			encoder.BindPipeline(vk::PipelineBindPoint::eGraphics, GetPipeline(pipeline).get());
+			m_meshes[mesh]->Bind(encoder);
+			m_meshes[mesh]->Draw(encoder.get(), count, firstObject);
+			draws++;
+		});
+		m_drawsRecorded.fetch_add(draws, std::memory_order_relaxed);
+	}
+
+	void BuildFrameGraph() {
+		m_frameGraph.Clear();
+
+		// Batched mode records a single secondary per chunk, one chunk per thread unless tuned
+		size_t chunkSize = m_graphChunkSize;
+		if (m_recordingMode != RecordingMode::ePerMesh) {
+			size_t batchCount = m_batchCount > 0 ? m_batchCount : m_threadPool.size() + 1;
+			chunkSize = std::max<size_t>(1, (m_objects.size() + batchCount - 1) / batchCount);
+		}
+		m_chunkCount = std::max<size_t>(1, (m_objects.size() + chunkSize - 1) / chunkSize);
+
+		// Bounds and stale object entries are known once the scene is updated,
+		// chunks only know their share of the visible list once culling ran
+		auto scene = m_frameGraph.CreateResource("scene");
+		m_frameGraph.AddNode("scene", {}, { scene }, [this] {
+			UpdateScene();
+		});
+		auto visible = m_frameGraph.CreateResource("visible");
+		m_frameGraph.AddNode("cull", { scene }, { visible }, [this] {
+			CullObjects();
+		});
+
+		// Object entries do not depend on culling, recording only needs the visible list
+		std::vector<toast::TaskGraph::ResourceId> recordedChunks;
+		size_t drawCount = 0;
+		for (size_t chunk = 0; chunk < m_chunkCount; ++chunk) {
+			auto uniforms = m_frameGraph.CreateResource(std::format("uniforms[{}]", chunk));
+			m_frameGraph.AddNode(std::format("ubo[{}]", chunk), { scene }, { uniforms }, [this, chunk] {
+				auto [begin, end] = ChunkRange(chunk, m_pendingWrites.size());
+				UpdateUniforms(begin, end);
+			});
+
+			// The GPU only needs the transforms, everything it draws comes out of the culling pass
+			if (m_recordingMode == RecordingMode::eGpuDriven) {
+				continue;
+			}
+
+			// Counted with nothing culled yet
+			auto [begin, end] = ChunkRange(chunk, m_visible.size());
+			if (m_recordingMode == RecordingMode::ePerMesh) {
+				drawCount += end - begin;
+			} else {
+				ForEachDraw(begin, end, [&](uint32_t, uint32_t, uint32_t, uint32_t) { drawCount++; });
+			}
+
+			auto secondaries = m_frameGraph.CreateResource(std::format("secondaries[{}]", chunk));
+			m_frameGraph.AddNode(std::format("record[{}]", chunk), { visible }, { secondaries }, [this, chunk] {
+				auto [begin, end] = ChunkRange(chunk, m_visible.size());
+				RecordSecondaries(chunk, begin, end);
+			});
+			recordedChunks.push_back(secondaries);
+		}
+		m_secondaryHandles.resize(m_recordingMode == RecordingMode::ePerMesh ? m_objects.size() : recordedChunks.size());
+		if (m_recordingMode == RecordingMode::eGpuDriven) {
+			drawCount = 1;
+		}
+
+		// The object set changed, nothing cached is valid anymore
+		m_retainedSecondaries.clear();
+		if (m_recordingMode == RecordingMode::eRetained) {
+			m_retainedSecondaries.resize(m_framesInFlight);
+			for (auto& frameSecondaries : m_retainedSecondaries) {
+				for (size_t chunk = 0; chunk < recordedChunks.size(); ++chunk) {
+					frameSecondaries.push_back(std::make_unique<vulkan::RetainedCommandBuffer>());
 				}
+			}
+		}
+		m_chunkVersions.assign(recordedChunks.size(), 0);
+		InvalidateRecording();
+
+		auto primary = m_frameGraph.CreateResource("primary");
+		recordedChunks.push_back(visible); // culling also sizes the handle list in per-mesh mode
+		m_frameGraph.AddNode("primary", recordedChunks, { primary }, [this] {
+			RecordPrimary();
+		});
+
+		m_frameGraph.Compile();
+		std::println("Built frame graph with {} nodes, {} secondaries and {} draws per frame before culling",
+			m_frameGraph.size(), m_secondaryHandles.size(), drawCount);
+	}
+
+	/// @brief Rewrites the stale object entries [begin, end) of the pending list
+	void UpdateUniforms(size_t begin, size_t end) {
+		auto objects = m_frameData->objects(m_currentFrame);
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t object = m_pendingWrites[i];
+			objects[object].model = m_scene.world(m_objectNodes[object]);
+		}
+	}
+
+	void UpdateCamera() {
+		vulkan::CameraData& camera = m_frameData->camera(m_currentFrame);
+		camera.view = glm::lookAt(
+			glm::vec3(0.0f, 15.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f)
+		);
+		auto extent = vulkan::Swapchain::extent();
+		float aspectRatio = extent.width / (float)extent.height;
+		camera.proj = glm::perspectiveRH_ZO(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f); // Vulkan depth range
+		camera.proj[1][1] *= -1;
+		camera.viewProj = camera.proj * camera.view;
+	}
 
-				completedCount.fetch_add(1);
+	void RecordSecondaries(size_t chunk, size_t begin, size_t end) {
+		auto recordStart = std::chrono::steady_clock::now();
+
+		// Each thread gets its own command pool per frame in flight
+		auto& threadPool = vulkan::CommandPool::GetForCurrentThread(m_currentFrame);
+
+		if (m_recordingMode == RecordingMode::eRetained) {
+			// Replay what was recorded for this frame slot unless the chunk changed since
+			auto& retained = *m_retainedSecondaries[m_currentFrame][chunk];
+			if (retained.IsStale(m_chunkVersions[chunk])) {
+				RecordSecondary(retained.Rerecord(m_chunkVersions[chunk]), [&](vulkan::CommandEncoder& encoder) {
+					DrawObjects(encoder, begin, end);
+				});
+				m_rerecordedChunks.fetch_add(1, std::memory_order_relaxed);
+			}
+			m_secondaryHandles[chunk] = retained.handle();
+		} else if (m_recordingMode == RecordingMode::eBatched) {
+			// Whole chunk in one buffer, pipeline state set once
+			auto& secondaryCmd = threadPool.AcquireBuffer(vk::CommandBufferLevel::eSecondary);
+			RecordSecondary(secondaryCmd, [&](vulkan::CommandEncoder& encoder) {
+				DrawObjects(encoder, begin, end);
 			});
+			m_secondaryHandles[chunk] = *secondaryCmd.get();
+		} else {
+			// One buffer per visible object, each lands at its slot
+			for (size_t slot = begin; slot < end; ++slot) {
+				auto& secondaryCmd = threadPool.AcquireBuffer(vk::CommandBufferLevel::eSecondary);
+				RecordSecondary(secondaryCmd, [&](vulkan::CommandEncoder& encoder) {
+					DrawObjects(encoder, slot, slot + 1);
+				});
+				m_secondaryHandles[slot] = *secondaryCmd.get();
+			}
 		}
 
-		// Wait for all secondary command buffers to be recorded
-		while (completedCount.load() < m_meshes.size()) {
-			std::this_thread::yield();
+		m_recordTime.fetch_add((std::chrono::steady_clock::now() - recordStart).count(), std::memory_order_relaxed);
+	}
+
+	/// @brief Records a secondary that continues the frame's rendering, with everything but the pipeline already bound
+	template<typename Func>
+	void RecordSecondary(vulkan::CommandBuffer& secondaryCmd, Func&& drawFunc) {
+		// Inheritance info for secondary command buffer
+		vk::Format swapchainFormat = vulkan::Swapchain::format();
+		vk::CommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &swapchainFormat,
+			.depthAttachmentFormat = vulkan::Swapchain::depthFormat(),
+			.rasterizationSamples = vk::SampleCountFlagBits::e1
+		};
+
+		vk::CommandBufferInheritanceInfo inheritanceInfo{
+			.pNext = &inheritanceRenderingInfo
+		};
+
+		auto flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+
+		secondaryCmd.Encode([&](vulkan::CommandEncoder& encoder) {
+			BindDrawState(encoder);
+			drawFunc(encoder);
+		}, flags, &inheritanceInfo);
+		m_stateCommandsIssued.fetch_add(secondaryCmd.encoderStats().totalIssued(), std::memory_order_relaxed);
+		CountEncoderStats(secondaryCmd.encoderStats());
+	}
+
+	/// @brief Binds the frame's object data and all geometry, sets viewport/scissor. Draws bind their pipeline
+	void BindDrawState(vulkan::CommandEncoder& encoder) {
+		m_frameData->Bind(encoder, m_pipeline->GetPipelineLayout(), m_currentFrame);
+		m_geometry->arena().Bind(encoder);
+		auto extent = vulkan::Swapchain::extent();
+		encoder.SetViewport(vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
+		encoder.SetScissor(vk::Rect2D({0, 0}, extent));
+	}
+
+	/// @brief Adds what a buffer's encoder issued and elided to the profiling counters
+	void CountEncoderStats(const vulkan::EncoderStats& stats) {
+		for (size_t i = 0; i < vulkan::ENCODER_COMMAND_COUNT; ++i) {
+			m_encoderIssued[i].fetch_add(stats.issued[i], std::memory_order_relaxed);
+			m_encoderElided[i].fetch_add(stats.elided[i], std::memory_order_relaxed);
 		}
+	}
 
-		// Record primary command buffer
-		m_commandBuffers[m_currentFrame].Record([&](vk::raii::CommandBuffer& cmd) {
-			// Transition image for rendering
+	/// @brief Begins rendering to the acquired image and the depth buffer, clearing both or keeping what is there
+	void BeginRendering(vk::raii::CommandBuffer& cmd, bool clear, vk::RenderingFlags flags) {
+		vk::RenderingAttachmentInfo colorAttachment{
+			.imageView = vulkan::Swapchain::view(m_imageIndex),
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f)
+		};
+		vk::RenderingAttachmentInfo depthAttachment{
+			.imageView = vulkan::Swapchain::depthImage().view(),
+			.imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+			.loadOp = clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearDepthStencilValue{ .depth = 1.0f, .stencil = 0 }
+		};
+
+		cmd.beginRendering(vk::RenderingInfo{
+			.flags = flags,
+			.renderArea = { .offset = {0, 0}, .extent = vulkan::Swapchain::extent() },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &colorAttachment,
+			.pDepthAttachment = &depthAttachment
+		});
+	}
+
+	/// @brief Marks cached secondaries of every chunk as stale, e.g. after the pipeline or swapchain changed
+	void InvalidateRecording() {
+		++m_recordingVersion;
+		std::ranges::fill(m_chunkVersions, m_recordingVersion);
+	}
+
+	void RecordPrimary() {
+		m_primaryCommandBuffer = &vulkan::CommandPool::GetForCurrentThread(m_currentFrame).AcquireBuffer();
+		m_primaryCommandBuffer->Encode([&](vulkan::CommandEncoder& encoder) {
+			vk::raii::CommandBuffer& cmd = encoder.get();
+			bool gpuDriven = m_recordingMode == RecordingMode::eGpuDriven;
+			if (gpuDriven) {
+				m_gpuCulling->Cull(cmd, m_currentFrame, m_frameData->camera(m_currentFrame).viewProj);
+			}
+
+			// Transition image and depth buffer for rendering, depth is cleared so its old content can go.
+			// Both transition stencil too when the depth format has it, depth alone would need separateDepthStencilLayouts
 			vulkan::CommandBuffer::TransitionImageLayout(
 				cmd,
-				vulkan::Swapchain::image(image_index),
+				vulkan::Swapchain::image(m_imageIndex),
 				vk::ImageLayout::eUndefined,
 				vk::ImageLayout::eColorAttachmentOptimal,
 				{},
@@ -218,41 +913,43 @@ private:
 				vk::PipelineStageFlagBits2::eTopOfPipe,
 				vk::PipelineStageFlagBits2::eColorAttachmentOutput
 			);
+			vulkan::CommandBuffer::TransitionImageLayout(
+				cmd,
+				vulkan::Swapchain::depthImage().handle(),
+				vk::ImageLayout::eUndefined,
+				vk::ImageLayout::eDepthStencilAttachmentOptimal,
+				vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+				vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+				vk::PipelineStageFlagBits2::eLateFragmentTests,
+				vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+				vulkan::Swapchain::depthAspects()
+			);
 
-			// Begin rendering
-			vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
-			vk::RenderingAttachmentInfo colorAttachment{
-				.imageView = vulkan::Swapchain::view(image_index),
-				.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
-				.loadOp = vk::AttachmentLoadOp::eClear,
-				.storeOp = vk::AttachmentStoreOp::eStore,
-				.clearValue = clearColor
-			};
-
-			vk::RenderingInfo renderingInfo{
-				.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers,
-				.renderArea = { .offset = {0, 0}, .extent = vulkan::Swapchain::extent() },
-				.layerCount = 1,
-				.colorAttachmentCount = 1,
-				.pColorAttachments = &colorAttachment
-			};
-
-			cmd.beginRendering(renderingInfo);
-
-			// Execute secondary command buffers
-			std::vector<vk::CommandBuffer> secondaryCmds;
-			secondaryCmds.reserve(m_meshes.size());
-			for (auto& secondaryCmd : secondaryBuffers) {
-				secondaryCmds.push_back(*secondaryCmd.get());
+			BeginRendering(cmd, true, gpuDriven ? vk::RenderingFlags{} : vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+			if (gpuDriven) {
+				// Same state the secondaries set up, then one draw for everything the culling pass kept
+				encoder.BindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
+				BindDrawState(encoder);
+				m_gpuCulling->Draw(cmd, m_currentFrame);
+			} else if (!m_secondaryHandles.empty()) {
+				// Execute secondary command buffers, per-mesh mode has none when everything was culled.
+				// They leave the primary's bound state undefined
+				cmd.executeCommands(m_secondaryHandles);
+				encoder.Invalidate();
 			}
-			cmd.executeCommands(secondaryCmds);
-
 			cmd.endRendering();
 
+			if (m_occlusion) {
+				RecordOcclusionPass(encoder);
+			}
+			if (gpuDriven) {
+				m_gpuCulling->ResolveStats(cmd, m_currentFrame);
+			}
+
 			// Transition for present
 			vulkan::CommandBuffer::TransitionImageLayout(
 				cmd,
-				vulkan::Swapchain::image(image_index),
+				vulkan::Swapchain::image(m_imageIndex),
 				vk::ImageLayout::eColorAttachmentOptimal,
 				vk::ImageLayout::ePresentSrcKHR,
 				vk::AccessFlagBits2::eColorAttachmentWrite,
@@ -261,37 +958,130 @@ private:
 				vk::PipelineStageFlagBits2::eBottomOfPipe
 			);
 		});
+		CountEncoderStats(m_primaryCommandBuffer->encoderStats());
+	}
+
+	/// @brief Reduces what the first pass drew to the depth pyramid, then draws whatever it shows became visible
+	void RecordOcclusionPass(vulkan::CommandEncoder& encoder) {
+		vk::raii::CommandBuffer& cmd = encoder.get();
+		vulkan::CommandBuffer::TransitionImageLayout(
+			cmd,
+			vulkan::Swapchain::depthImage().handle(),
+			vk::ImageLayout::eDepthStencilAttachmentOptimal,
+			vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+			vk::AccessFlagBits2::eShaderSampledRead,
+			vk::PipelineStageFlagBits2::eLateFragmentTests,
+			vk::PipelineStageFlagBits2::eComputeShader,
+			vulkan::Swapchain::depthAspects()
+		);
+		m_depthPyramid->Build(cmd);
+		vulkan::CommandBuffer::TransitionImageLayout(
+			cmd,
+			vulkan::Swapchain::depthImage().handle(),
+			vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::ImageLayout::eDepthStencilAttachmentOptimal,
+			{},
+			vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+			vk::PipelineStageFlagBits2::eComputeShader,
+			vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+			vulkan::Swapchain::depthAspects()
+		);
+
+		m_gpuCulling->CullOccluded(cmd, m_currentFrame, m_frameData->camera(m_currentFrame).viewProj);
+
+		// The pyramid and the culling pass only bind compute state, the graphics state of the first pass is still bound
+		BeginRendering(cmd, false, {});
+		encoder.BindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
+		BindDrawState(encoder);
+		m_gpuCulling->Draw(cmd, m_currentFrame, 1);
+		cmd.endRendering();
+	}
+
+	void drawFrame() {
+		// This slot was last used m_framesInFlight submits ago, everything of it is free once that frame finished
+		if (m_submittedFrames >= m_framesInFlight) {
+			WaitForFrame(m_submittedFrames + 1 - m_framesInFlight);
+		}
+		if (m_gpuCulling) {
+			m_gpuCulling->CollectStats(m_currentFrame);
+		}
+		// Geometry released from now on may be read by this frame, what finished frames used can be reused
+		m_geometry->AdvanceFrame(m_submittedFrames + 1, CompletedFrames());
+		if (m_geometry->generation() != m_geometryGeneration) {
+			OnGeometryMoved();
+		}
+		
+		// Recycle every buffer recorded for this frame slot now that its frame has finished
+		vulkan::CommandPool::ResetFrame(m_currentFrame);
+		
+		auto [result, image_index] = m_swapchain->get().acquireNextImage(std::numeric_limits<uint64_t>::max(), *m_presentCompleteSemaphores[m_currentFrame], nullptr);
+
+		if (result == vk::Result::eErrorOutOfDateKHR) {
+			recreateSwapChain();
+			return;
+		}
+		if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+			throw std::runtime_error("failed to acquire swap chain image!");
+		}
+
+		rotation += 1.f * 0.166f;
+		m_frameSpin = glm::angleAxis(glm::radians(rotation), glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)));
+		m_imageIndex = image_index;
+
+		// Camera once, then object updates, secondary recording and the primary buffer
+		UpdateCamera();
+		m_frameGraph.Execute(m_threadPool);
 
-		// Submit
-		vk::PipelineStageFlags waitStage(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		vk::Semaphore waitSemaphore = *m_presentCompleteSemaphores[m_currentFrame];
-		vk::Semaphore signalSemaphore = *m_renderFinishedSemaphores[m_currentFrame];
-		vk::CommandBuffer cmdBuffer = *m_commandBuffers[m_currentFrame].get();
+		// Submit, culling and vertex input also wait for whatever the upload manager has in flight.
+		// The present waits on the image's semaphore, the frame timeline counts the finished frame
+		std::array<vk::PipelineStageFlags, 2> waitStages = {
+			vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eVertexInput
+		};
+		std::array<vk::Semaphore, 2> waitSemaphores = { *m_presentCompleteSemaphores[m_currentFrame], m_uploads->timeline() };
+		std::array<uint64_t, 2> waitValues = { 0, m_uploads->lastSubmitted() }; // binary semaphores ignore their value
+		std::array<vk::Semaphore, 2> signalSemaphores = { *m_renderFinishedSemaphores[image_index], *m_frameTimeline };
+		std::array<uint64_t, 2> signalValues = { 0, m_submittedFrames + 1 };
+		vk::CommandBuffer cmdBuffer = *m_primaryCommandBuffer->get();
 
+		vk::TimelineSemaphoreSubmitInfo timelineInfo{
+			.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+			.pWaitSemaphoreValues = waitValues.data(),
+			.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size()),
+			.pSignalSemaphoreValues = signalValues.data()
+		};
 		vk::SubmitInfo submitInfo{
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &waitSemaphore,
-			.pWaitDstStageMask = &waitStage,
+			.pNext = &timelineInfo,
+			.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+			.pWaitSemaphores = waitSemaphores.data(),
+			.pWaitDstStageMask = waitStages.data(),
 			.commandBufferCount = 1,
 			.pCommandBuffers = &cmdBuffer,
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = &signalSemaphore
+			.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()),
+			.pSignalSemaphores = signalSemaphores.data()
 		};
-		m_device->queue().submit(submitInfo, *m_drawFences[m_currentFrame]);
-
-		// Store secondary buffers for this frame so they live until fence signals
-		m_secondaryCommandBuffers[m_currentFrame] = std::move(secondaryBuffers);
+		auto submitStart = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(vulkan::Device::queueMutex());
+			m_device->queue().submit(submitInfo, nullptr);
+		}
+		m_submitTime += (std::chrono::steady_clock::now() - submitStart).count();
+		++m_submittedFrames;
 
 		// Present
 		vk::SwapchainKHR swapchain = *m_swapchain->get();
 		vk::PresentInfoKHR presentInfo{
 			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &signalSemaphore,
+			.pWaitSemaphores = &signalSemaphores[0],
 			.swapchainCount = 1,
 			.pSwapchains = &swapchain,
 			.pImageIndices = &image_index
 		};
-		result = m_device->queue().presentKHR(presentInfo);
+		{
+			std::lock_guard<std::mutex> lock(vulkan::Device::queueMutex());
+			result = m_device->queue().presentKHR(presentInfo);
+		}
 		
 		if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || m_framebufferResized) {
 			m_framebufferResized = false;
@@ -300,12 +1090,140 @@ private:
 			throw std::runtime_error("failed to present swap chain image!");
 		}
 		
-		m_currentFrame = (m_currentFrame + 1) % m_presentCompleteSemaphores.size();
+		if (++m_frameNumber % m_profileInterval == 0) {
+			PrintFrameStats();
+		}
+
+		m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+	}
+
+	void PrintFrameStats() {
+		std::println("Frame {} ({} finished on the GPU, up to {} in flight):", m_frameNumber, CompletedFrames(), m_framesInFlight);
+		m_frameGraph.DumpCriticalPath();
+
+		double frames = static_cast<double>(m_profileInterval);
+		constexpr const char* modeNames[] = { "per-mesh", "batched", "retained", "gpu" };
+		std::println("{} objects, {} recording: {:.3f} ms CPU record, {:.3f} ms submit, {:.2f} chunks re-recorded per frame",
+			m_objects.size(), modeNames[static_cast<int>(m_recordingMode)],
+			m_recordTime.exchange(0) / 1e6 / frames, m_submitTime / 1e6 / frames, m_rerecordedChunks.exchange(0) / frames);
+		m_submitTime = 0;
+
+		std::println("Scene: {:.1f} of {} nodes changed, {:.3f} ms update, {:.1f} object entries written per frame",
+			m_changedNodes / frames, m_scene.size(), m_sceneTime / 1e6 / frames, m_objectWrites / frames);
+		m_sceneTime = 0;
+		m_changedNodes = 0;
+		m_objectWrites = 0;
+
+		auto cullStats = m_culler.ConsumeStats();
+		if (cullStats.tested > 0) {
+			constexpr const char* kernelNames[] = { "scalar", "SSE", "AVX2" };
+			std::println("Culling: {:.1f} of {} objects visible, {:.3f} ms, {:.2f} objects/ns with {}",
+				cullStats.visible / frames, m_objects.size(), cullStats.time / 1e6 / frames,
+				static_cast<double>(cullStats.tested) / std::max<int64_t>(cullStats.time, 1), kernelNames[static_cast<int>(m_culler.kernel())]);
+		}
+
+		auto bvhStats = m_bvh.ConsumeStats();
+		if (bvhStats.queries > 0) {
+			std::println("BVH: {} nodes, {} builds {:.3f} ms, {:.3f} ms refit, {:.3f} ms query, {:.1f} nodes visited and {:.1f} of {} objects visible per frame",
+				m_bvh.nodeCount(), bvhStats.builds, bvhStats.buildTime / 1e6, bvhStats.refitTime / 1e6 / frames, bvhStats.queryTime / 1e6 / frames,
+				bvhStats.nodesVisited / frames, bvhStats.visible / frames, m_objects.size());
+		}
+
+		if (m_gpuCulling) {
+			auto gpuStats = m_gpuCulling->ConsumeStats();
+			double resolved = static_cast<double>(std::max<uint64_t>(gpuStats.frames, 1));
+			if (m_occlusion) {
+				std::println("GPU culling: {:.1f} drawn ({:.1f} visible last frame, {:.1f} newly visible), {:.1f} occluded and {:.1f} outside the frustum per frame",
+					(gpuStats.firstPassDraws + gpuStats.secondPassDraws) / resolved, gpuStats.firstPassDraws / resolved,
+					gpuStats.secondPassDraws / resolved, gpuStats.occluded / resolved, gpuStats.outsideFrustum / resolved);
+			} else {
+				std::println("GPU culling: {:.1f} drawn and {:.1f} outside the frustum per frame",
+					gpuStats.firstPassDraws / resolved, gpuStats.outsideFrustum / resolved);
+			}
+		}
+
+		auto queueStats = m_renderQueue.ConsumeStats();
+		uint64_t drawsRecorded = m_drawsRecorded.exchange(0);
+		uint64_t stateCommands = m_stateCommandsIssued.exchange(0);
+		if (queueStats.sorts > 0 || drawsRecorded > 0) {
+			double sorts = static_cast<double>(std::max<uint64_t>(queueStats.sorts, 1));
+			std::println("Render queue: {} sorts of {:.1f} keys, {:.3f} ms and {:.1f} radix passes each, {:.1f} of {:.1f} state commands elided per frame",
+				queueStats.sorts, queueStats.keys / sorts, queueStats.sortTime / 1e6 / sorts, queueStats.passes / sorts,
+				(static_cast<double>(drawsRecorded * DRAW_STATE_COMMANDS) - static_cast<double>(stateCommands)) / frames, drawsRecorded * DRAW_STATE_COMMANDS / frames);
+		}
+
+		uint64_t encoderIssued = 0;
+		uint64_t encoderElided = 0;
+		std::string encoderCommands;
+		constexpr const char* commandNames[] = { "pipeline", "descriptor sets", "vertex buffers", "index buffer", "viewport", "scissor", "push constants" };
+		for (size_t i = 0; i < vulkan::ENCODER_COMMAND_COUNT; ++i) {
+			uint64_t issued = m_encoderIssued[i].exchange(0);
+			uint64_t elided = m_encoderElided[i].exchange(0);
+			encoderIssued += issued;
+			encoderElided += elided;
+			if (issued + elided > 0) {
+				encoderCommands += std::format(", {} {:.1f}/{:.1f}", commandNames[i], issued / frames, elided / frames);
+			}
+		}
+		if (encoderIssued + encoderElided > 0) {
+			std::println("Command encoder: {:.1f} issued and {:.1f} elided per frame (issued/elided{})",
+				encoderIssued / frames, encoderElided / frames, encoderCommands);
+		}
+
+		auto poolStats = vulkan::CommandPool::ConsumeStats();
+		std::println("Command buffers: {:.1f} acquired, {:.2f} allocated per frame",
+			poolStats.acquired / frames, poolStats.allocated / frames);
+	}
+
+	/// @brief Times the radix sort against std::sort on random keys, then returns without opening a window
+	void RunSortBenchmark() {
+		m_threadPool.Init(4);
+		size_t count = m_sortBenchmarkKeys;
+		std::mt19937_64 rng(42);
+		std::vector<uint64_t> sourceKeys(count);
+		for (uint64_t& key : sourceKeys) {
+			key = rng();
+		}
+
+		constexpr int RUNS = 10;
+		std::vector<uint64_t> keys(count), keyScratch(count);
+		std::vector<uint32_t> values(count), valueScratch(count);
+		std::vector<toast::RadixHistogram> histograms, offsets;
+		int64_t radixTime = 0;
+		size_t passes = 0;
+		for (int run = 0; run < RUNS; ++run) {
+			keys = sourceKeys;
+			std::iota(values.begin(), values.end(), 0u);
+			auto sortStart = std::chrono::steady_clock::now();
+			passes = toast::RadixSort(m_threadPool, keys, values, keyScratch, valueScratch, histograms, offsets);
+			radixTime += (std::chrono::steady_clock::now() - sortStart).count();
+		}
+
+		// Values break ties, so the reference is stable like the radix sort
+		std::vector<std::pair<uint64_t, uint32_t>> reference(count);
+		int64_t referenceTime = 0;
+		for (int run = 0; run < RUNS; ++run) {
+			for (uint32_t i = 0; i < count; ++i) {
+				reference[i] = { sourceKeys[i], i };
+			}
+			auto sortStart = std::chrono::steady_clock::now();
+			std::ranges::sort(reference);
+			referenceTime += (std::chrono::steady_clock::now() - sortStart).count();
+		}
+
+		bool matches = std::ranges::equal(keys, reference, {}, {}, &std::pair<uint64_t, uint32_t>::first)
+			&& std::ranges::equal(values, reference, {}, {}, &std::pair<uint64_t, uint32_t>::second);
+		std::println("Sorted {} random keys {} times: {:.3f} ms radix sort ({} passes, {} threads), {:.3f} ms std::sort, results {}",
+			count, RUNS, radixTime / 1e6 / RUNS, passes, m_threadPool.size() + 1, referenceTime / 1e6 / RUNS, matches ? "match" : "differ");
+		m_threadPool.Destroy();
 	}
 
 	void recreateSwapChain() {
 		m_swapchain->recreate();
-		CreateCommandBuffers();
+		CreateRenderFinishedSemaphores(); // the image count may have changed, recreate waited for the device
+		CreateDepthPyramid();
+		// Cached secondaries bake the extent and the color format
+		InvalidateRecording();
 	}
 
 	void mainLoop() {
@@ -314,20 +1232,23 @@ private:
 			drawFrame();
 		}
 
-		m_device->get().waitIdle();
-		
-		// Clear all secondary command buffers before destroying thread pool
-		for (auto& buffers : m_secondaryCommandBuffers) {
-			buffers.clear();
+		{
+			std::lock_guard<std::mutex> lock(vulkan::Device::queueMutex());
+			m_device->get().waitIdle();
 		}
 		
+		// Retained buffers come from the workers' pools, free them before the workers exit and take their pools along
+		m_retainedSecondaries.clear();
+		// Workers drop their frame and retained pools when they exit, the main thread's are released here
 		m_threadPool.Destroy();
+		vulkan::CommandPool::DestroyThreadPools();
 	}
 };
 
-int main() {
+int main(int argc, char** argv) {
 	try {
 		HelloTriangleApplication app;
+		app.ParseArguments(argc, argv);
 		app.run();
 	} catch (const std::exception &e) {
 		std::println(stderr, "{}", e.what());
@@ -0,0 +1,228 @@
+/// @file memory_allocator.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <print>
+#include <stdexcept>
+
+module vulkan.memory;
+import vulkan.device;
+
+namespace vulkan {
+
+MemoryAllocator::MemoryAllocator() {
+	if (m_thisMemoryAllocator) {
+		throw std::runtime_error("One Memory Allocator already exists");
+	}
+	m_thisMemoryAllocator = this;
+
+	// Properties never change for a device, query them once
+	m_memoryProperties = Device::physicalDevice().getMemoryProperties();
+	m_pools.resize(m_memoryProperties.memoryTypeCount * 2);
+
+	std::println("Created Memory Allocator over {} memory types", m_memoryProperties.memoryTypeCount);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+	if (m_allocationCount > 0) {
+		std::println("Memory Allocator destroyed with {} allocations still alive", m_allocationCount);
+	}
+	m_thisMemoryAllocator = nullptr;
+}
+
+MemoryAllocator* MemoryAllocator::memoryAllocator() {
+	if (!m_thisMemoryAllocator) {
+		throw std::runtime_error("Trying to access Memory Allocator but it doesn't exist yet");
+	}
+	return m_thisMemoryAllocator;
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const {
+	for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("failed to find suitable memory type!");
+}
+
+Allocation MemoryAllocator::Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, ResourceKind kind) {
+	uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+	uint32_t pool = memoryType * 2 + static_cast<uint32_t>(kind);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Rounding to a power of two at least as big as the alignment keeps buddies aligned
+	vk::DeviceSize rounded = std::bit_ceil(std::max(requirements.size, requirements.alignment));
+	uint32_t order = std::max<uint32_t>(MIN_ORDER, std::countr_zero(rounded));
+
+	MemoryBlock* block = nullptr;
+	vk::DeviceSize offset = 0;
+	if (order > MAX_ORDER - 2) {
+		block = &CreateBlock(pool, requirements.size, true);
+		block->used = requirements.size;
+	} else {
+		for (auto& candidate : m_pools[pool]) {
+			if (AllocateFromBlock(*candidate, order, offset)) {
+				block = candidate.get();
+				break;
+			}
+		}
+		if (!block) {
+			block = &CreateBlock(pool, BLOCK_SIZE, false);
+			AllocateFromBlock(*block, order, offset);
+		}
+	}
+
+	m_bytesInUse += requirements.size;
+	m_allocationCount++;
+
+	return Allocation{
+		.memory = *block->memory,
+		.offset = offset,
+		.size = requirements.size,
+		.mapped = block->mapped ? block->mapped + offset : nullptr,
+		.block = block,
+		.order = order
+	};
+}
+
+void MemoryAllocator::Free(Allocation& allocation) {
+	if (!allocation) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	MemoryBlock* block = allocation.block;
+	m_bytesInUse -= allocation.size;
+	m_allocationCount--;
+
+	if (block->dedicated) {
+		ReleaseBlock(block);
+	} else {
+		FreeToBlock(*block, allocation.order, allocation.offset);
+		// Keep one empty block around per pool so a free/allocate pattern doesn't thrash the driver
+		if (block->used == 0 && m_pools[block->pool].size() > 1) {
+			ReleaseBlock(block);
+		}
+	}
+	allocation = Allocation{};
+}
+
+MemoryBlock& MemoryAllocator::CreateBlock(uint32_t pool, vk::DeviceSize size, bool dedicated) {
+	uint32_t memoryType = pool / 2;
+	auto block = std::make_unique<MemoryBlock>();
+	block->memory = vk::raii::DeviceMemory(Device::get(), vk::MemoryAllocateInfo{ .allocationSize = size, .memoryTypeIndex = memoryType });
+	block->size = size;
+	block->pool = pool;
+	block->dedicated = dedicated;
+
+	if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+		block->mapped = static_cast<std::byte*>(block->memory.mapMemory(0, size));
+	}
+
+	if (dedicated) {
+		m_dedicated.push_back(std::move(block));
+		return *m_dedicated.back();
+	}
+
+	block->freeLists.resize(MAX_ORDER + 1);
+	block->freeLists[MAX_ORDER].insert(0);
+	m_pools[pool].push_back(std::move(block));
+	return *m_pools[pool].back();
+}
+
+void MemoryAllocator::ReleaseBlock(MemoryBlock* block) {
+	auto& blocks = block->dedicated ? m_dedicated : m_pools[block->pool];
+	auto it = std::ranges::find_if(blocks, [block](const auto& candidate) { return candidate.get() == block; });
+	if (it != blocks.end()) {
+		blocks.erase(it);
+	}
+}
+
+bool MemoryAllocator::AllocateFromBlock(MemoryBlock& block, uint32_t order, vk::DeviceSize& offset) {
+	uint32_t current = order;
+	while (current <= MAX_ORDER && block.freeLists[current].empty()) {
+		current++;
+	}
+	if (current > MAX_ORDER) {
+		return false;
+	}
+
+	offset = *block.freeLists[current].begin();
+	block.freeLists[current].erase(block.freeLists[current].begin());
+
+	// Split down, the upper halves go back to the free lists
+	while (current > order) {
+		current--;
+		block.freeLists[current].insert(offset + (vk::DeviceSize(1) << current));
+	}
+
+	block.used += vk::DeviceSize(1) << order;
+	return true;
+}
+
+void MemoryAllocator::FreeToBlock(MemoryBlock& block, uint32_t order, vk::DeviceSize offset) {
+	block.used -= vk::DeviceSize(1) << order;
+
+	// Merge with the buddy for as long as it is free too
+	while (order < MAX_ORDER) {
+		vk::DeviceSize buddy = offset ^ (vk::DeviceSize(1) << order);
+		auto it = block.freeLists[order].find(buddy);
+		if (it == block.freeLists[order].end()) {
+			break;
+		}
+		block.freeLists[order].erase(it);
+		offset = std::min(offset, buddy);
+		order++;
+	}
+	block.freeLists[order].insert(offset);
+}
+
+MemoryAllocator::Stats MemoryAllocator::stats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Stats stats{
+		.bytesInUse = m_bytesInUse,
+		.dedicatedCount = static_cast<uint32_t>(m_dedicated.size()),
+		.allocationCount = m_allocationCount
+	};
+
+	vk::DeviceSize freeBytes = 0;
+	vk::DeviceSize largestFree = 0;
+	for (const auto& pool : m_pools) {
+		for (const auto& block : pool) {
+			stats.bytesReserved += block->size;
+			stats.blockCount++;
+			freeBytes += block->size - block->used;
+			for (uint32_t order = MAX_ORDER + 1; order-- > MIN_ORDER;) {
+				if (!block->freeLists[order].empty()) {
+					largestFree = std::max(largestFree, vk::DeviceSize(1) << order);
+					break;
+				}
+			}
+		}
+	}
+	for (const auto& block : m_dedicated) {
+		stats.bytesReserved += block->size;
+	}
+
+	stats.fragmentation = freeBytes > 0 ? 1.0f - static_cast<float>(largestFree) / static_cast<float>(freeBytes) : 0.0f;
+	return stats;
+}
+
+void MemoryAllocator::DumpStats() const {
+	Stats current = stats();
+	std::println("Device memory: {:.2f} MiB in use of {:.2f} MiB reserved, {} allocations in {} blocks + {} dedicated, {:.1f}% fragmented",
+		current.bytesInUse / (1024.0 * 1024.0), current.bytesReserved / (1024.0 * 1024.0),
+		current.allocationCount, current.blockCount, current.dedicatedCount, current.fragmentation * 100.0f);
+}
+
+}
@@ -0,0 +1,105 @@
+/// @file memory_allocator.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+export module vulkan.memory;
+import vulkan.device;
+
+namespace vulkan {
+
+/// @brief Resources placed in the same pool, linear and optimal ones never share a block
+/// so bufferImageGranularity never has to be checked between neighbours
+export enum class ResourceKind : uint32_t {
+	eLinear,  // buffers and linear images
+	eOptimal  // optimally tiled images
+};
+
+/// One vkAllocateMemory, either split with a buddy scheme or owned by a single dedicated allocation
+struct MemoryBlock {
+	vk::raii::DeviceMemory memory = nullptr;
+	std::byte* mapped = nullptr;
+	vk::DeviceSize size = 0;
+	vk::DeviceSize used = 0;
+	uint32_t pool = 0;
+	bool dedicated = false;
+	std::vector<std::set<vk::DeviceSize>> freeLists; // free offsets per order, lowest address first
+};
+
+/// @brief Sub-range of device memory handed out by the MemoryAllocator
+export struct Allocation {
+	vk::DeviceMemory memory;
+	vk::DeviceSize offset = 0;
+	vk::DeviceSize size = 0;
+	void* mapped = nullptr; // persistently mapped when the memory is host visible
+	MemoryBlock* block = nullptr;
+	uint32_t order = 0;
+
+	explicit operator bool() const { return block != nullptr; }
+};
+
+/// @brief Sub-allocates device memory out of large blocks per memory type
+/// @note Sizes are rounded up to a power of two and split with a buddy allocator, which keeps
+/// every allocation aligned to its own size. Anything bigger than a quarter block gets dedicated memory
+export class MemoryAllocator {
+public:
+	MemoryAllocator();
+	~MemoryAllocator();
+	static MemoryAllocator* memoryAllocator();
+
+	[[nodiscard]]
+	static MemoryAllocator& get() { return *memoryAllocator(); }
+
+	struct Stats {
+		vk::DeviceSize bytesInUse = 0;    // requested by live allocations
+		vk::DeviceSize bytesReserved = 0; // allocated from the driver
+		uint32_t blockCount = 0;
+		uint32_t dedicatedCount = 0;
+		uint32_t allocationCount = 0;
+		float fragmentation = 0.0f;       // 1 - largest free range / free bytes, over pooled blocks
+	};
+
+	[[nodiscard]]
+	Allocation Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, ResourceKind kind = ResourceKind::eLinear);
+
+	void Free(Allocation& allocation);
+
+	/// @brief First memory type allowed by typeFilter with every property requested
+	[[nodiscard]]
+	uint32_t FindMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+
+	[[nodiscard]]
+	Stats stats() const;
+
+	void DumpStats() const;
+
+	static constexpr uint32_t MIN_ORDER = 8;   // 256 B
+	static constexpr uint32_t MAX_ORDER = 26;  // 64 MiB blocks
+	static constexpr vk::DeviceSize BLOCK_SIZE = vk::DeviceSize(1) << MAX_ORDER;
+
+private:
+	MemoryBlock& CreateBlock(uint32_t pool, vk::DeviceSize size, bool dedicated);
+	void ReleaseBlock(MemoryBlock* block);
+	static bool AllocateFromBlock(MemoryBlock& block, uint32_t order, vk::DeviceSize& offset);
+	static void FreeToBlock(MemoryBlock& block, uint32_t order, vk::DeviceSize offset);
+
+	static MemoryAllocator* m_thisMemoryAllocator;
+	mutable std::mutex m_mutex;
+	vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+	std::vector<std::vector<std::unique_ptr<MemoryBlock>>> m_pools; // memory type * 2 + kind
+	std::vector<std::unique_ptr<MemoryBlock>> m_dedicated;
+	vk::DeviceSize m_bytesInUse = 0;
+	uint32_t m_allocationCount = 0;
+};
+
+MemoryAllocator* MemoryAllocator::m_thisMemoryAllocator = nullptr;
+
+}
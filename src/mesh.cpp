@@ -5,101 +5,51 @@
 module;
 
 #include <vulkan/vulkan_raii.hpp>
+#include <algorithm>
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 
 module vulkan.mesh;
-import vulkan.buffers;
-import vulkan.device;
-import vulkan.swapchain;
+import vulkan.geometry;
+import vulkan.commandencoder;
 
 namespace vulkan {
 
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-	: m_vertexCount(static_cast<uint32_t>(vertices.size()))
-	, m_indexCount(static_cast<uint32_t>(indices.size()))
+	: m_geometry(GeometryRegistry::get().Acquire(std::as_bytes(std::span(vertices)), indices))
+	, m_boundingSphere(0.0f)
 {
-	// Get the number of frames from swapchain images
-	uint32_t frameCount = static_cast<uint32_t>(Swapchain::get().getImages().size());
-
-	// Create vertex buffer
-	vk::DeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-	m_vertexBuffer = std::make_unique<Buffer>(
-		vertexBufferSize,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-		vk::MemoryPropertyFlagBits::eDeviceLocal
-	);
-
-	// Upload vertex data via staging buffer
-	Buffer stagingBuffer(
-		vertexBufferSize,
-		vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-	);
-
-	void* data = stagingBuffer.getMemory().mapMemory(0, vertexBufferSize);
-	memcpy(data, vertices.data(), vertexBufferSize);
-	stagingBuffer.getMemory().unmapMemory();
-
-	stagingBuffer.copyBuffer(m_vertexBuffer->getBuffer(), vertexBufferSize);
-
-	// Create index buffer if indices provided
-	if (!indices.empty()) {
-		vk::DeviceSize indexBufferSize = sizeof(uint32_t) * indices.size();
-		m_indexBuffer = std::make_unique<Buffer>(
-			indexBufferSize,
-			vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-			vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-
-		Buffer indexStagingBuffer(
-			indexBufferSize,
-			vk::BufferUsageFlagBits::eTransferSrc,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-		);
-
-		data = indexStagingBuffer.getMemory().mapMemory(0, indexBufferSize);
-		memcpy(data, indices.data(), indexBufferSize);
-		indexStagingBuffer.getMemory().unmapMemory();
-
-		indexStagingBuffer.copyBuffer(m_indexBuffer->getBuffer(), indexBufferSize);
+	if (vertices.empty()) {
+		return;
 	}
 
-	// Descriptors are initialized later via InitDescriptors with pipeline set layout
-}
-
-void Mesh::InitDescriptors(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount) {
-	// copy layout handle
-	m_descriptorSetLayout = vk::raii::DescriptorSetLayout(Device::get(), *setLayout);
-	CreateUniformBuffers(frameCount);
-	CreateDescriptorPool(frameCount);
-	CreateDescriptorSets();
-}
-
-void Mesh::Bind(vk::raii::CommandBuffer& cmdBuffer, const vk::raii::PipelineLayout& pipelineLayout, uint32_t frameIndex) const {
-	vk::Buffer vertexBuffer = *m_vertexBuffer->getBuffer();
-	vk::DeviceSize offset = 0;
-	cmdBuffer.bindVertexBuffers(0, vertexBuffer, offset);
+	// Centered on the bounding box, loose but cheap and stable
+	glm::vec3 min = vertices.front().position;
+	glm::vec3 max = min;
+	for (const Vertex& vertex : vertices) {
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+	glm::vec3 center = (min + max) * 0.5f;
 
-	if (m_indexBuffer) {
-		cmdBuffer.bindIndexBuffer(*m_indexBuffer->getBuffer(), 0, vk::IndexType::eUint32);
+	float radius = 0.0f;
+	for (const Vertex& vertex : vertices) {
+		radius = std::max(radius, glm::length(vertex.position - center));
 	}
+	m_boundingSphere = glm::vec4(center, radius);
+}
 
-	// Bind descriptor set for this frame
-	cmdBuffer.bindDescriptorSets(
-		vk::PipelineBindPoint::eGraphics,
-		*pipelineLayout,
-		0,
-		*m_descriptorSets[frameIndex],
-		nullptr
-	);
+void Mesh::Bind(CommandEncoder& encoder) const {
+	m_geometry->arena().Bind(encoder);
 }
 
-void Mesh::Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t instanceCount) const {
-	if (m_indexBuffer) {
-		cmdBuffer.drawIndexed(m_indexCount, instanceCount, 0, 0, 0);
+void Mesh::Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t instanceCount, uint32_t firstInstance) const {
+	if (m_geometry->indexCount() > 0) {
+		cmdBuffer.drawIndexed(m_geometry->indexCount(), instanceCount, m_geometry->firstIndex(),
+			static_cast<int32_t>(m_geometry->firstVertex()), firstInstance);
 	} else {
-		cmdBuffer.draw(m_vertexCount, instanceCount, 0, 0);
+		cmdBuffer.draw(m_geometry->vertexCount(), instanceCount, m_geometry->firstVertex(), firstInstance);
 	}
 }
 
@@ -169,77 +119,4 @@ Mesh Mesh::CreateCube() {
 	return Mesh(vertices, indices);
 }
 
-void Mesh::CreateUniformBuffers(uint32_t frameCount) {
-	vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-
-	m_uniformBuffers.resize(frameCount);
-	m_uniformBuffersMapped.resize(frameCount);
-
-	for (uint32_t i = 0; i < frameCount; ++i) {
-		m_uniformBuffers[i] = std::make_unique<Buffer>(
-			bufferSize,
-			vk::BufferUsageFlagBits::eUniformBuffer,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-		);
-
-		// Map the buffer memory persistently
-		m_uniformBuffersMapped[i] = m_uniformBuffers[i]->getMemory().mapMemory(0, bufferSize);
-	}
-}
-
-void Mesh::CreateDescriptorPool(uint32_t frameCount) {
-	vk::DescriptorPoolSize poolSize{
-		.type = vk::DescriptorType::eUniformBuffer,
-		.descriptorCount = frameCount
-	};
-
-	vk::DescriptorPoolCreateInfo poolInfo{
-		.flags = {},
-		.maxSets = frameCount,
-		.poolSizeCount = 1,
-		.pPoolSizes = &poolSize
-	};
-
-	m_descriptorPool = vk::raii::DescriptorPool(Device::get(), poolInfo);
-}
-
-void Mesh::CreateDescriptorSets() {
-	uint32_t frameCount = static_cast<uint32_t>(m_uniformBuffers.size());
-	std::vector<vk::DescriptorSetLayout> layouts(frameCount, *m_descriptorSetLayout);
-
-	vk::DescriptorSetAllocateInfo allocInfo{
-		.descriptorPool = *m_descriptorPool,
-		.descriptorSetCount = frameCount,
-		.pSetLayouts = layouts.data()
-	};
-
-	m_descriptorSets = vk::raii::DescriptorSets(Device::get(), allocInfo);
-
-	// Update descriptor sets to point to uniform buffers
-	for (uint32_t i = 0; i < frameCount; ++i) {
-		vk::DescriptorBufferInfo bufferInfo{
-			.buffer = *m_uniformBuffers[i]->getBuffer(),
-			.offset = 0,
-			.range = sizeof(UniformBufferObject)
-		};
-
-		vk::WriteDescriptorSet descriptorWrite{
-			.dstSet = *m_descriptorSets[i],
-			.dstBinding = 0,
-			.dstArrayElement = 0,
-			.descriptorCount = 1,
-			.descriptorType = vk::DescriptorType::eUniformBuffer,
-			.pImageInfo = nullptr,
-			.pBufferInfo = &bufferInfo,
-			.pTexelBufferView = nullptr
-		};
-
-		Device::get().updateDescriptorSets(descriptorWrite, nullptr);
-	}
-}
-
-void Mesh::UpdateUniformBuffer(uint32_t frameIndex, const UniformBufferObject& ubo) {
-	memcpy(m_uniformBuffersMapped[frameIndex], &ubo, sizeof(UniformBufferObject));
-}
-
 }
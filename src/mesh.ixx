@@ -5,11 +5,13 @@
 module;
 
 #include <vulkan/vulkan_raii.hpp>
+#include <memory>
 #include <vector>
 #include <glm/glm.hpp>
 
 export module vulkan.mesh;
-import vulkan.buffers;
+import vulkan.geometry;
+import vulkan.commandencoder;
 
 namespace vulkan {
 
@@ -61,60 +63,52 @@ export struct Vertex {
 	}
 };
 
-export struct UniformBufferObject {
-	glm::mat4 model;
-	glm::mat4 view;
-	glm::mat4 proj;
-};
-
+/// @brief Drawable geometry, meshes with identical content share one range of the geometry arena
 export class Mesh {
 public:
 	Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-	// New: create mesh UBO/descriptors from an external descriptor set layout
-	void InitDescriptors(const vk::raii::DescriptorSetLayout& setLayout, uint32_t frameCount);
 
-	/// @brief Bind this mesh's buffers to a command buffer
-	void Bind(vk::raii::CommandBuffer& cmdBuffer, const vk::raii::PipelineLayout& pipelineLayout, uint32_t frameIndex) const;
+	/// @brief Bind the geometry arena this mesh lives in, shared with every other mesh
+	/// @note The encoder drops the bind when another mesh already bound the arena
+	void Bind(CommandEncoder& encoder) const;
 
-	/// @brief Draw this mesh
-	void Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t instanceCount = 1) const;
+	/// @brief Draw this mesh, expects the geometry arena to be bound
+	/// @param firstInstance Index of the first instance's entry in the frame's object data
+	void Draw(vk::raii::CommandBuffer& cmdBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
 
 	/// @brief Bind and draw in one call
-	void BindAndDraw(vk::raii::CommandBuffer& cmdBuffer, const vk::raii::PipelineLayout& pipelineLayout, uint32_t frameIndex, uint32_t instanceCount = 1) const {
-		Bind(cmdBuffer, pipelineLayout, frameIndex);
-		Draw(cmdBuffer, instanceCount);
+	void BindAndDraw(CommandEncoder& encoder, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const {
+		Bind(encoder);
+		Draw(encoder.get(), instanceCount, firstInstance);
 	}
 
-	void UpdateUniformBuffer(uint32_t frameIndex, const UniformBufferObject& ubo);
+	[[nodiscard]]
+	uint32_t GetVertexCount() const { return m_geometry->vertexCount(); }
+	[[nodiscard]]
+	uint32_t GetIndexCount() const { return m_geometry->indexCount(); }
+	[[nodiscard]]
+	bool IsIndexed() const { return m_geometry->indexCount() > 0; }
 
+	/// @brief Meshes returning the same id draw the same buffers
+	[[nodiscard]]
+	uint32_t GetGeometryId() const { return m_geometry->id(); }
+	/// @brief Where the mesh lives in the geometry arena, for draws recorded by the GPU
 	[[nodiscard]]
-	uint32_t GetVertexCount() const { return m_vertexCount; }
+	uint32_t GetFirstIndex() const { return m_geometry->firstIndex(); }
 	[[nodiscard]]
-	uint32_t GetIndexCount() const { return m_indexCount; }
+	int32_t GetVertexOffset() const { return static_cast<int32_t>(m_geometry->firstVertex()); }
+
+	/// @brief Sphere around every vertex in mesh space, xyz center and w radius
 	[[nodiscard]]
-	bool IsIndexed() const { return m_indexCount > 0; }
+	const glm::vec4& GetBoundingSphere() const { return m_boundingSphere; }
 
 	static Mesh CreateTriangle();
 	static Mesh CreateQuad();
 	static Mesh CreateCube();
 
 private:
-	void CreateUniformBuffers(uint32_t frameCount);
-	void CreateDescriptorPool(uint32_t frameCount);
-	void CreateDescriptorSets();
-
-	std::unique_ptr<Buffer> m_vertexBuffer;
-	std::unique_ptr<Buffer> m_indexBuffer;
-
-	std::vector<std::unique_ptr<Buffer>> m_uniformBuffers;
-	std::vector<void*> m_uniformBuffersMapped;
-
-	vk::raii::DescriptorSetLayout m_descriptorSetLayout = nullptr; // external-owned copy
-	vk::raii::DescriptorPool m_descriptorPool = nullptr;
-	vk::raii::DescriptorSets m_descriptorSets = nullptr;
-	
-	uint32_t m_vertexCount;
-	uint32_t m_indexCount;
+	std::shared_ptr<const Geometry> m_geometry;
+	glm::vec4 m_boundingSphere;
 };
 
 }
@@ -3,6 +3,7 @@
 /// @date 27-Nov-2025
 module;
 
+#include <array>
 #include <fstream>
 #include <print>
 #include <vulkan/vulkan_raii.hpp>
@@ -28,7 +29,10 @@ std::vector<char> ReadFile(const std::string& path) {
 	return buffer;
 }
 
-Pipeline::Pipeline() {
+Pipeline::Pipeline(PipelineVariant variant, bool overdraw)
+	: m_variant(variant)
+	, m_overdraw(overdraw)
+{
 	std::println("Creating pipeline...");
 
 	CreateDescriptorSetLayout();
@@ -44,7 +48,10 @@ Pipeline::Pipeline() {
 	std::println("Created Pipeline");
 }
 
-Pipeline::Pipeline(const vk::raii::PipelineLayout& pipelineLayout) {
+Pipeline::Pipeline(const vk::raii::PipelineLayout& pipelineLayout, PipelineVariant variant, bool overdraw)
+	: m_variant(variant)
+	, m_overdraw(overdraw)
+{
 	std::println("Creating pipeline with external layout...");
 
 	auto shader_stages = CreateShaderStages();
@@ -84,7 +91,7 @@ Pipeline::ShaderStages Pipeline::CreateShaderStages() {
 	vk::PipelineShaderStageCreateInfo frag_info {
 		.stage = vk::ShaderStageFlagBits::eFragment,
 		.module = shaderModule,
-		.pName = "fragMain"
+		.pName = m_overdraw ? "fragOverdrawMain" : m_variant == PipelineVariant::eTransparent ? "fragTransparentMain" : "fragMain"
 	};
 
 	std::println("Created shader stages");
@@ -112,9 +119,10 @@ Pipeline::DynamicStates Pipeline::CreateDynamicStates() {
 }
 
 vk::PipelineColorBlendStateCreateInfo Pipeline::CreateColorBlendState(vk::PipelineColorBlendAttachmentState& attachment) {
-	attachment.blendEnable = vk::True;
-	attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-	attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+	// Overdraw sums every fragment, transparent ones blend over the color behind them
+	attachment.blendEnable = m_overdraw || m_variant == PipelineVariant::eTransparent ? vk::True : vk::False;
+	attachment.srcColorBlendFactor = m_overdraw ? vk::BlendFactor::eOne : vk::BlendFactor::eSrcAlpha;
+	attachment.dstColorBlendFactor = m_overdraw ? vk::BlendFactor::eOne : vk::BlendFactor::eOneMinusSrcAlpha;
 	attachment.colorBlendOp = vk::BlendOp::eAdd;
 	attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
 	attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
@@ -130,18 +138,37 @@ vk::PipelineColorBlendStateCreateInfo Pipeline::CreateColorBlendState(vk::Pipeli
 }
 
 void Pipeline::CreateDescriptorSetLayout() {
-	vk::DescriptorSetLayoutBinding uboLayoutBinding{
-		.binding = 0,
-		.descriptorType = vk::DescriptorType::eUniformBuffer,
-		.descriptorCount = 1,
-		.stageFlags = vk::ShaderStageFlagBits::eVertex,
-		.pImmutableSamplers = nullptr
+	std::array bindings = {
+		// Camera, written once per frame
+		vk::DescriptorSetLayoutBinding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eUniformBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.pImmutableSamplers = nullptr
+		},
+		// Per frame object data, indexed by object
+		vk::DescriptorSetLayoutBinding{
+			.binding = 1,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.pImmutableSamplers = nullptr
+		},
+		// Object of every instance slot
+		vk::DescriptorSetLayoutBinding{
+			.binding = 2,
+			.descriptorType = vk::DescriptorType::eStorageBuffer,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.pImmutableSamplers = nullptr
+		}
 	};
 
 	vk::DescriptorSetLayoutCreateInfo layoutInfo{
 		.flags = {},
-		.bindingCount = 1,
-		.pBindings = &uboLayoutBinding
+		.bindingCount = static_cast<uint32_t>(bindings.size()),
+		.pBindings = bindings.data()
 	};
 
 	m_descriptorSetLayout = vk::raii::DescriptorSetLayout(Device::get(), layoutInfo);
@@ -194,10 +221,21 @@ void Pipeline::CreateGraphicsPipeline(const ShaderStages& shader_stages, const D
 		.sampleShadingEnable = vk::False
 	};
 
+	// Nearest surface wins, the depth buffer is also what occlusion culling reads back.
+	// Transparent surfaces must not hide what is drawn behind them later
+	vk::PipelineDepthStencilStateCreateInfo depth_stencil {
+		.depthTestEnable = vk::True,
+		.depthWriteEnable = m_variant == PipelineVariant::eOpaque ? vk::True : vk::False,
+		.depthCompareOp = vk::CompareOp::eLess,
+		.depthBoundsTestEnable = vk::False,
+		.stencilTestEnable = vk::False
+	};
+
 	auto sw_format = Swapchain::format();
 	vk::PipelineRenderingCreateInfo pipeline_rendering_info {
 		.colorAttachmentCount = 1,
-		.pColorAttachmentFormats = &sw_format
+		.pColorAttachmentFormats = &sw_format,
+		.depthAttachmentFormat = Swapchain::depthFormat()
 	};
 
 	// Use external layout if provided, otherwise use own
@@ -212,6 +250,7 @@ void Pipeline::CreateGraphicsPipeline(const ShaderStages& shader_stages, const D
 		.pViewportState = &viewport_info,
 		.pRasterizationState = &rasterizer,
 		.pMultisampleState = &multisampling,
+		.pDepthStencilState = &depth_stencil,
 		.pColorBlendState = &color_blending,
 		.pDynamicState = &dynamic_states.info,
 		.layout = layout,
@@ -4,6 +4,7 @@
 module;
 
 #include <array>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan_raii.hpp>
 
@@ -13,10 +14,20 @@ import vulkan.swapchain;
 
 namespace vulkan {
 
+/// @brief Reads a whole binary file, used for SPIR-V
+export std::vector<char> ReadFile(const std::string& path);
+
+/// @brief How a pipeline's fragments land, opaque ones skip blending and feed early depth tests
+export enum class PipelineVariant {
+	eOpaque,      ///< No blending, depth tested and written
+	eTransparent  ///< Alpha blended over what is behind, depth tested but not written
+};
+
 export class Pipeline {
 public:
-	Pipeline();
-	Pipeline(const vk::raii::PipelineLayout& pipelineLayout);
+	/// @param overdraw Adds a constant per fragment instead of shading, so brightness shows how often a pixel was written
+	explicit Pipeline(PipelineVariant variant = PipelineVariant::eOpaque, bool overdraw = false);
+	Pipeline(const vk::raii::PipelineLayout& pipelineLayout, PipelineVariant variant = PipelineVariant::eOpaque, bool overdraw = false);
 	
 	[[nodiscard]]
 	vk::raii::Pipeline& get() { return m_pipeline; }
@@ -58,6 +69,8 @@ private:
 	vk::raii::DescriptorSetLayout m_descriptorSetLayout = nullptr;
 	vk::raii::PipelineLayout m_pipelineLayout = nullptr;
 	vk::raii::Pipeline m_pipeline = nullptr;
+	PipelineVariant m_variant;
+	bool m_overdraw;
 };
 
 }
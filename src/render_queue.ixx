@@ -0,0 +1,270 @@
+/// @file render_queue.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+export module render_queue;
+import thread_pool;
+
+namespace toast {
+
+/// @brief 64-bit draw sort key, most significant field first: pass, pipeline, geometry, material, depth
+/// @note Everything above the depth is state a draw needs bound, so sorted keys put draws sharing it next to each other.
+/// Blended passes put the depth right below the pass instead, their draws must follow the depth order across all
+/// of their state and only neighbours sharing it are batched
+export struct SortKey {
+	static constexpr uint32_t PASS_BITS = 2;
+	static constexpr uint32_t PIPELINE_BITS = 6;
+	static constexpr uint32_t GEOMETRY_BITS = 16;
+	static constexpr uint32_t MATERIAL_BITS = 8;
+	static constexpr uint32_t DEPTH_BITS = 32;
+	static constexpr uint32_t STATE_BITS = PIPELINE_BITS + GEOMETRY_BITS + MATERIAL_BITS;
+
+	// Positions inside the state bits, which sit above the depth or below it depending on the pass
+	static constexpr uint32_t GEOMETRY_SHIFT = MATERIAL_BITS;
+	static constexpr uint32_t PIPELINE_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+	static constexpr uint32_t PASS_SHIFT = STATE_BITS + DEPTH_BITS;
+	static_assert(PASS_SHIFT + PASS_BITS == 64);
+
+	/// @brief First pass whose keys order by depth before any state
+	static constexpr uint32_t DEPTH_FIRST_PASS = 1;
+
+	/// @note Fields are masked to their width, callers check their ranges fit
+	[[nodiscard]]
+	static constexpr uint64_t Pack(uint32_t pass, uint32_t pipeline, uint32_t geometry, uint32_t material, uint32_t depth) {
+		uint64_t state = Field(pipeline, PIPELINE_BITS) << PIPELINE_SHIFT
+			| Field(geometry, GEOMETRY_BITS) << GEOMETRY_SHIFT
+			| Field(material, MATERIAL_BITS);
+		uint64_t key = Field(pass, PASS_BITS) << PASS_SHIFT;
+		return DepthFirst(key)
+			? key | uint64_t{depth} << STATE_BITS | state
+			: key | state << DEPTH_BITS | depth;
+	}
+
+	[[nodiscard]]
+	static constexpr uint32_t Pass(uint64_t key) { return Extract(key, PASS_SHIFT, PASS_BITS); }
+	[[nodiscard]]
+	static constexpr uint32_t Pipeline(uint64_t key) { return Extract(StateBits(key), PIPELINE_SHIFT, PIPELINE_BITS); }
+	[[nodiscard]]
+	static constexpr uint32_t Geometry(uint64_t key) { return Extract(StateBits(key), GEOMETRY_SHIFT, GEOMETRY_BITS); }
+	[[nodiscard]]
+	static constexpr uint32_t Material(uint64_t key) { return Extract(StateBits(key), 0, MATERIAL_BITS); }
+	[[nodiscard]]
+	static constexpr uint32_t Depth(uint64_t key) {
+		return static_cast<uint32_t>(DepthFirst(key) ? key >> STATE_BITS : key);
+	}
+
+	/// @brief Every field but the depth, equal for draws that can share their bound state
+	[[nodiscard]]
+	static constexpr uint64_t State(uint64_t key) { return uint64_t{Pass(key)} << STATE_BITS | StateBits(key); }
+
+	/// @brief Bits of a float that compare like the float, smaller depths sort first
+	[[nodiscard]]
+	static constexpr uint32_t DepthBits(float depth) {
+		uint32_t bits = std::bit_cast<uint32_t>(depth);
+		return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+	}
+
+private:
+	static constexpr uint64_t Field(uint32_t value, uint32_t bits) { return value & ((uint64_t{1} << bits) - 1); }
+	static constexpr bool DepthFirst(uint64_t key) { return Pass(key) >= DEPTH_FIRST_PASS; }
+	static constexpr uint64_t StateBits(uint64_t key) {
+		return (DepthFirst(key) ? key : key >> DEPTH_BITS) & ((uint64_t{1} << STATE_BITS) - 1);
+	}
+	static constexpr uint32_t Extract(uint64_t key, uint32_t shift, uint32_t bits) {
+		return static_cast<uint32_t>(key >> shift & ((uint64_t{1} << bits) - 1));
+	}
+};
+
+constexpr size_t RADIX_BITS = 8;
+constexpr size_t RADIX_BUCKETS = size_t{1} << RADIX_BITS;
+constexpr size_t RADIX_PASSES = 64 / RADIX_BITS;
+constexpr size_t RADIX_CHUNK_SIZE = 16384; // keys below which a sort is not split further
+
+/// @brief Count or offset of every bucket of one byte
+export using RadixHistogram = std::array<uint32_t, RADIX_BUCKETS>;
+
+/// @brief Sorts keys ascending with a stable LSD radix sort, moving values along with them
+/// @note One pass per byte, chunks histogram and scatter their share in parallel. Bytes equal in every key are skipped,
+/// so fields that are constant for the whole set cost nothing. Scratch spans need the size of keys and values,
+/// the histogram vectors are resized as needed and only allocate when a sort uses more chunks than any before
+/// @return Number of scatter passes that ran
+export size_t RadixSort(ThreadPool& pool, std::span<uint64_t> keys, std::span<uint32_t> values,
+	std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch,
+	std::vector<RadixHistogram>& histograms, std::vector<RadixHistogram>& offsets);
+
+/// @brief Consecutive entries of a sorted RenderQueue sharing every key field but the depth
+export struct RenderRun {
+	uint64_t key;       // key of the first entry, its fields are the run's state
+	uint32_t first;
+	uint32_t count;
+};
+
+/// @brief What a RenderQueue did since the last ConsumeStats, times in ns
+export struct RenderQueueStats {
+	int64_t sortTime = 0;
+	uint64_t sorts = 0;
+	uint64_t keys = 0;
+	uint64_t passes = 0; // radix passes that ran, out of 8 per sort
+};
+
+/// @brief Draw list of one frame as sort keys with a payload each, sorted so draws sharing state are adjacent
+/// @note Fill keys() and values() after Resize, then Sort. Runs are only valid after Sort
+export class RenderQueue {
+public:
+	void Resize(size_t count);
+
+	/// @brief Sorts by key and splits the result into runs of equal state
+	void Sort(ThreadPool& pool);
+
+	[[nodiscard]]
+	std::span<uint64_t> keys() { return m_keys; }
+	[[nodiscard]]
+	std::span<uint32_t> values() { return m_values; }
+	[[nodiscard]]
+	std::span<const uint32_t> values() const { return m_values; }
+	[[nodiscard]]
+	std::span<const RenderRun> runs() const { return m_runs; }
+	[[nodiscard]]
+	size_t size() const { return m_keys.size(); }
+
+	RenderQueueStats ConsumeStats() { return std::exchange(m_stats, {}); }
+
+private:
+	std::vector<uint64_t> m_keys;
+	std::vector<uint32_t> m_values;
+	std::vector<uint64_t> m_keyScratch;
+	std::vector<uint32_t> m_valueScratch;
+	std::vector<RadixHistogram> m_histograms;
+	std::vector<RadixHistogram> m_offsets;
+	std::vector<RenderRun> m_runs;
+	RenderQueueStats m_stats;
+};
+
+size_t RadixSort(ThreadPool& pool, std::span<uint64_t> keys, std::span<uint32_t> values,
+	std::span<uint64_t> keyScratch, std::span<uint32_t> valueScratch,
+	std::vector<RadixHistogram>& histograms, std::vector<RadixHistogram>& offsets) {
+	size_t count = keys.size();
+	if (count < 2) {
+		return 0;
+	}
+
+	// Chunks keep their range for every pass, a chunk's entries always land after those of the chunks before it
+	size_t chunkCount = std::clamp<size_t>(count / RADIX_CHUNK_SIZE, 1, pool.size() + 1);
+	size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	chunkCount = (count + chunkSize - 1) / chunkSize;
+	auto forEachChunk = [&](auto&& func) {
+		pool.ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+			for (size_t chunk = begin; chunk < end; ++chunk) {
+				func(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+			}
+		});
+	};
+
+	// Every byte's histogram at once, the totals tell which passes would leave the order as it is
+	histograms.assign(chunkCount * RADIX_PASSES, RadixHistogram{});
+	forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+		RadixHistogram* chunkHistograms = &histograms[chunk * RADIX_PASSES];
+		for (size_t i = begin; i < end; ++i) {
+			uint64_t key = keys[i];
+			for (size_t pass = 0; pass < RADIX_PASSES; ++pass) {
+				chunkHistograms[pass][key >> (pass * RADIX_BITS) & (RADIX_BUCKETS - 1)]++;
+			}
+		}
+	});
+
+	std::span<uint64_t> srcKeys = keys;
+	std::span<uint32_t> srcValues = values;
+	std::span<uint64_t> dstKeys = keyScratch;
+	std::span<uint32_t> dstValues = valueScratch;
+	offsets.resize(chunkCount);
+	size_t passesRun = 0;
+	for (size_t pass = 0; pass < RADIX_PASSES; ++pass) {
+		size_t shift = pass * RADIX_BITS;
+		uint64_t digit = keys[0] >> shift & (RADIX_BUCKETS - 1);
+		uint32_t sameDigit = 0;
+		for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+			sameDigit += histograms[chunk * RADIX_PASSES + pass][digit];
+		}
+		if (sameDigit == count) {
+			continue;
+		}
+
+		// Histograms of earlier bytes still count the current chunks, later passes moved entries between them
+		if (passesRun > 0) {
+			forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+				RadixHistogram& histogram = histograms[chunk * RADIX_PASSES + pass];
+				histogram.fill(0);
+				for (size_t i = begin; i < end; ++i) {
+					histogram[srcKeys[i] >> shift & (RADIX_BUCKETS - 1)]++;
+				}
+			});
+		}
+
+		// Bucket by bucket, each chunk writes after the same bucket of the chunks before it
+		uint32_t offset = 0;
+		for (size_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket) {
+			for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+				offsets[chunk][bucket] = offset;
+				offset += histograms[chunk * RADIX_PASSES + pass][bucket];
+			}
+		}
+
+		forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+			RadixHistogram& chunkOffsets = offsets[chunk];
+			for (size_t i = begin; i < end; ++i) {
+				uint32_t target = chunkOffsets[srcKeys[i] >> shift & (RADIX_BUCKETS - 1)]++;
+				dstKeys[target] = srcKeys[i];
+				dstValues[target] = srcValues[i];
+			}
+		});
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+		++passesRun;
+	}
+
+	// An odd pass count leaves the result in the scratch spans
+	if (srcKeys.data() != keys.data()) {
+		std::ranges::copy(srcKeys, keys.begin());
+		std::ranges::copy(srcValues, values.begin());
+	}
+	return passesRun;
+}
+
+void RenderQueue::Resize(size_t count) {
+	m_keys.resize(count);
+	m_values.resize(count);
+	m_keyScratch.resize(count);
+	m_valueScratch.resize(count);
+	m_runs.clear();
+}
+
+void RenderQueue::Sort(ThreadPool& pool) {
+	auto sortStart = std::chrono::steady_clock::now();
+
+	m_stats.passes += RadixSort(pool, m_keys, m_values, m_keyScratch, m_valueScratch, m_histograms, m_offsets);
+
+	m_runs.clear();
+	for (uint32_t i = 0; i < m_keys.size(); ++i) {
+		if (m_runs.empty() || SortKey::State(m_runs.back().key) != SortKey::State(m_keys[i])) {
+			m_runs.push_back(RenderRun{ .key = m_keys[i], .first = i, .count = 0 });
+		}
+		m_runs.back().count++;
+	}
+
+	m_stats.sortTime += (std::chrono::steady_clock::now() - sortStart).count();
+	m_stats.sorts++;
+	m_stats.keys += m_keys.size();
+}
+
+}
@@ -0,0 +1,193 @@
+/// @file scene_graph.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+export module scene_graph;
+import thread_pool;
+import transform_store;
+
+namespace toast {
+
+/// @brief Hierarchy of transforms in flat arrays, a parent always has a lower index than its children
+/// @note Only subtrees below a changed node are recomputed, so a static scene costs nothing to update
+export class SceneGraph {
+public:
+	using NodeId = uint32_t;
+	static constexpr NodeId NO_NODE = ~0u;
+	static_assert(NO_NODE == TransformStore::NO_PARENT, "Roots are passed to the transform store as they are");
+
+	/// @brief Adds an identity node below parent, which has to exist already
+	NodeId AddNode(NodeId parent = NO_NODE);
+
+	void SetPosition(NodeId node, const glm::vec3& position);
+	/// @param rotation Has to be normalized
+	void SetRotation(NodeId node, const glm::quat& rotation);
+	void SetScale(NodeId node, const glm::vec3& scale);
+
+	/// @brief World matrix as of the last Update
+	[[nodiscard]]
+	const glm::mat4& world(NodeId node) const { return m_world[node]; }
+
+	[[nodiscard]]
+	NodeId parent(NodeId node) const { return m_parents[node]; }
+
+	/// @brief Recomputes world matrices of every changed node and everything below it, one depth level at a time
+	/// split over the pool. Nodes with a slot in mirror get their world matrix written there as well
+	/// @return Nodes whose world matrix was recomputed, by depth so parents come before children, valid until the next call
+	std::span<const NodeId> Update(ThreadPool& pool, const MatrixMirror& mirror = {});
+
+	/// @brief Removes every node
+	void Clear();
+
+	[[nodiscard]]
+	size_t size() const { return m_parents.size(); }
+
+private:
+	// Nodes per job, a level smaller than this is computed on the calling thread
+	static constexpr size_t GRAIN_SIZE = 1024;
+
+	void MarkDirty(NodeId node);
+
+	std::vector<NodeId> m_parents;
+	std::vector<uint32_t> m_depths;
+	size_t m_levelCount = 0;
+	std::vector<NodeId> m_firstChild;
+	std::vector<NodeId> m_nextSibling;
+	TransformStore m_local;
+	std::vector<glm::mat4> m_world;
+
+	// Nodes changed since the last Update, each listed once
+	std::vector<uint8_t> m_dirty;
+	std::vector<NodeId> m_dirtyNodes;
+
+	// Scratch of Update, kept to not allocate every frame
+	std::vector<NodeId> m_changed;
+	std::vector<NodeId> m_byLevel;
+	std::vector<size_t> m_levelStarts;
+	std::vector<NodeId> m_stack;
+};
+
+SceneGraph::NodeId SceneGraph::AddNode(NodeId parent) {
+	NodeId node = static_cast<NodeId>(m_parents.size());
+	if (parent != NO_NODE && parent >= node) {
+		throw std::runtime_error("SceneGraph parents have to be added before their children");
+	}
+
+	m_parents.push_back(parent);
+	m_depths.push_back(parent == NO_NODE ? 0 : m_depths[parent] + 1);
+	m_levelCount = std::max<size_t>(m_levelCount, m_depths.back() + 1);
+	m_firstChild.push_back(NO_NODE);
+	m_nextSibling.push_back(NO_NODE);
+	if (parent != NO_NODE) {
+		m_nextSibling[node] = m_firstChild[parent];
+		m_firstChild[parent] = node;
+	}
+
+	m_local.Resize(m_parents.size());
+	m_world.emplace_back(1.0f);
+	m_dirty.push_back(0);
+	MarkDirty(node);
+	return node;
+}
+
+void SceneGraph::SetPosition(NodeId node, const glm::vec3& position) {
+	m_local.SetPosition(node, position);
+	MarkDirty(node);
+}
+
+void SceneGraph::SetRotation(NodeId node, const glm::quat& rotation) {
+	m_local.SetRotation(node, rotation);
+	MarkDirty(node);
+}
+
+void SceneGraph::SetScale(NodeId node, const glm::vec3& scale) {
+	m_local.SetScale(node, scale);
+	MarkDirty(node);
+}
+
+void SceneGraph::MarkDirty(NodeId node) {
+	if (!m_dirty[node]) {
+		m_dirty[node] = 1;
+		m_dirtyNodes.push_back(node);
+	}
+}
+
+std::span<const SceneGraph::NodeId> SceneGraph::Update(ThreadPool& pool, const MatrixMirror& mirror) {
+	m_changed.clear();
+	if (m_dirtyNodes.empty()) {
+		return m_changed;
+	}
+
+	// Ancestors come first, so a dirty node below another one was already covered by its subtree
+	std::ranges::sort(m_dirtyNodes);
+	for (NodeId root : m_dirtyNodes) {
+		if (!m_dirty[root]) {
+			continue;
+		}
+
+		m_stack.push_back(root);
+		while (!m_stack.empty()) {
+			NodeId node = m_stack.back();
+			m_stack.pop_back();
+			m_dirty[node] = 0;
+			m_changed.push_back(node);
+			for (NodeId child = m_firstChild[node]; child != NO_NODE; child = m_nextSibling[child]) {
+				m_stack.push_back(child);
+			}
+		}
+	}
+	m_dirtyNodes.clear();
+
+	// Bucket by depth, a level only reads world matrices of the levels above it
+	m_levelStarts.assign(m_levelCount + 1, 0);
+	for (NodeId node : m_changed) {
+		m_levelStarts[m_depths[node] + 1]++;
+	}
+	for (size_t level = 1; level <= m_levelCount; ++level) {
+		m_levelStarts[level] += m_levelStarts[level - 1];
+	}
+	m_byLevel.resize(m_changed.size());
+	for (NodeId node : m_changed) {
+		m_byLevel[m_levelStarts[m_depths[node]]++] = node;
+	}
+	// Filling moved every start to the next level's, shift them back
+	for (size_t level = m_levelCount; level > 0; --level) {
+		m_levelStarts[level] = m_levelStarts[level - 1];
+	}
+	m_levelStarts[0] = 0;
+	std::swap(m_changed, m_byLevel);
+
+	for (size_t level = 0; level < m_levelCount; ++level) {
+		std::span<const NodeId> nodes(m_changed.data() + m_levelStarts[level], m_changed.data() + m_levelStarts[level + 1]);
+		pool.ParallelFor(nodes.size(), GRAIN_SIZE, [&](size_t begin, size_t end) {
+			m_local.WriteWorldMatrices(nodes.subspan(begin, end - begin), m_parents.data(), m_world.data(), mirror);
+		});
+	}
+
+	return m_changed;
+}
+
+void SceneGraph::Clear() {
+	m_parents.clear();
+	m_depths.clear();
+	m_levelCount = 0;
+	m_firstChild.clear();
+	m_nextSibling.clear();
+	m_local.Resize(0);
+	m_world.clear();
+	m_dirty.clear();
+	m_dirtyNodes.clear();
+	m_changed.clear();
+}
+
+}
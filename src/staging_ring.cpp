@@ -0,0 +1,69 @@
+/// @file staging_ring.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstddef>
+#include <optional>
+#include <print>
+
+module vulkan.staging;
+import vulkan.buffers;
+
+namespace vulkan {
+
+StagingRing::StagingRing(vk::DeviceSize capacity)
+	: m_buffer(
+		capacity,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+	, m_capacity(capacity)
+{
+	m_mapped = static_cast<std::byte*>(m_buffer.Map());
+	std::println("Created staging ring of {} KiB", capacity / 1024);
+}
+
+std::optional<StagingAllocation> StagingRing::Allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+	if (size > m_capacity) {
+		return std::nullopt;
+	}
+
+	vk::DeviceSize offset = (m_head + alignment - 1) / alignment * alignment;
+
+	// Allocations never straddle the end, skip to the start of the next lap instead
+	vk::DeviceSize lapStart = offset - offset % m_capacity;
+	if (offset + size > lapStart + m_capacity) {
+		offset = lapStart + m_capacity;
+	}
+
+	if (offset + size - m_tail > m_capacity) {
+		return std::nullopt;
+	}
+
+	m_head = offset + size;
+	vk::DeviceSize wrapped = offset % m_capacity;
+	return StagingAllocation{
+		.buffer = *m_buffer.getBuffer(),
+		.offset = wrapped,
+		.data = m_mapped + wrapped
+	};
+}
+
+void StagingRing::Retire(uint64_t value) {
+	if (!hasPending()) {
+		return;
+	}
+	m_regions.push_back(Region{ .value = value, .end = m_head });
+	m_retiredHead = m_head;
+}
+
+void StagingRing::Reclaim(uint64_t completed) {
+	while (!m_regions.empty() && m_regions.front().value <= completed) {
+		m_tail = m_regions.front().end;
+		m_regions.pop_front();
+	}
+}
+
+}
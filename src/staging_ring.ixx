@@ -0,0 +1,72 @@
+/// @file staging_ring.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+export module vulkan.staging;
+import vulkan.buffers;
+
+namespace vulkan {
+
+/// @brief Sub-range of the staging ring, valid until the value it was retired with completes
+export struct StagingAllocation {
+	vk::Buffer buffer;
+	vk::DeviceSize offset = 0;
+	void* data = nullptr;
+};
+
+/// @brief Persistently mapped host-visible buffer handing out sub-ranges in FIFO order
+/// @note Space is given back in whole regions, each tagged with the timeline value of the submission that read it.
+/// Not synchronized, the owner serializes access
+export class StagingRing {
+public:
+	explicit StagingRing(vk::DeviceSize capacity);
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	/// @brief Carves size bytes aligned to alignment out of the ring
+	/// @return Nothing if the ring doesn't have enough free space right now
+	std::optional<StagingAllocation> Allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+	/// @brief Tags everything allocated since the last call as in use until value completes
+	void Retire(uint64_t value);
+
+	/// @brief Gives back the space of every region retired with a value up to completed
+	void Reclaim(uint64_t completed);
+
+	[[nodiscard]]
+	vk::DeviceSize capacity() const { return m_capacity; }
+
+	/// @brief Bytes not available for allocation, including padding lost to alignment and wrapping
+	[[nodiscard]]
+	vk::DeviceSize used() const { return m_head - m_tail; }
+
+	/// @brief Whether space is held by allocations that were not retired yet
+	[[nodiscard]]
+	bool hasPending() const { return m_head != m_retiredHead; }
+
+private:
+	struct Region {
+		uint64_t value;
+		vk::DeviceSize end; // head when the region was retired
+	};
+
+	Buffer m_buffer;
+	vk::DeviceSize m_capacity;
+	std::byte* m_mapped = nullptr;
+
+	// Monotonic positions, wrapped by capacity when addressing the buffer
+	vk::DeviceSize m_head = 0;
+	vk::DeviceSize m_tail = 0;
+	vk::DeviceSize m_retiredHead = 0;
+	std::deque<Region> m_regions;
+};
+
+}
@@ -1,9 +1,11 @@
 module;
 
+#include <mutex>
 #include <print>
 #include <stdexcept>
 #include <vulkan/vulkan_raii.hpp>
 import vulkan.device;
+import vulkan.image;
 import window;
 
 module vulkan.swapchain;
@@ -83,6 +85,7 @@ void Swapchain::createSwapchain() {
 	m_format = m_surfaceFormat.format;
 
 	CreateImageViews();
+	CreateDepthImage();
 
 	std::println("Created Swapchain");
 }
@@ -147,7 +150,20 @@ void Swapchain::CreateImageViews() {
 	std::println("Created {} Image Views", m_imageViews.size());
 }
 
+void Swapchain::CreateDepthImage() {
+	// Sampled as well, occlusion culling reduces it to a depth pyramid. The view only covers depth,
+	// that is what gets attached and sampled even when the format carries stencil
+	m_depthImage = std::make_unique<Image>(
+		m_extent,
+		FindDepthFormat(),
+		vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
+		vk::ImageAspectFlagBits::eDepth
+	);
+	std::println("Created {}x{} depth buffer", m_extent.width, m_extent.height);
+}
+
 void Swapchain::cleanup() {
+	m_depthImage.reset();
 	m_imageViews.clear();
 	m_swapchain.clear();
 }
@@ -164,7 +180,10 @@ void Swapchain::recreate() {
 		window()->waitEvents();
 	}
 
-	Device::get().waitIdle();
+	{
+		std::lock_guard<std::mutex> lock(Device::queueMutex());
+		Device::get().waitIdle();
+	}
 
 	cleanup();
 	createSwapchain();
@@ -4,8 +4,10 @@
 module;
 
 #include <vulkan/vulkan_raii.hpp>
+#include <memory>
 
 export module vulkan.swapchain;
+import vulkan.image;
 
 namespace vulkan {
 
@@ -26,9 +28,19 @@ public:
 	[[nodiscard]]
 	static vk::raii::ImageView& view(std::size_t index) { return swapchain()->m_imageViews[index]; }
 	[[nodiscard]]
+	static uint32_t imageCount() { return static_cast<uint32_t>(swapchain()->m_images.size()); }
+	[[nodiscard]]
 	static vk::Format format() { return swapchain()->m_format; }
 	[[nodiscard]]
 	static vk::Extent2D extent() { return swapchain()->m_extent; }
+	/// @brief Depth buffer shared by every image, same extent as the swapchain and recreated with it
+	[[nodiscard]]
+	static Image& depthImage() { return *swapchain()->m_depthImage; }
+	[[nodiscard]]
+	static vk::Format depthFormat() { return swapchain()->m_depthImage->format(); }
+	/// @brief Aspects depth barriers name, stencil too when the format has it even though nothing uses it
+	[[nodiscard]]
+	static vk::ImageAspectFlags depthAspects() { return FormatAspects(depthFormat()); }
 
 private:
 	static Swapchain* m_instance;
@@ -40,12 +52,14 @@ private:
 	vk::Format m_format = vk::Format::eUndefined;
 	vk::PresentModeKHR m_presentMode;
 	vk::Extent2D m_extent;
+	std::unique_ptr<Image> m_depthImage;
 
 	void createSwapchain();
 	vk::SurfaceFormatKHR ChooseSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& formats);
 	vk::PresentModeKHR ChoosePresentMode(const std::vector<vk::PresentModeKHR>& modes);
 	vk::Extent2D ChooseExtent(const vk::SurfaceCapabilitiesKHR& capabilities);
 	void CreateImageViews();
+	void CreateDepthImage();
 };
 
 export Swapchain* swapchain() { return Swapchain::swapchain(); }
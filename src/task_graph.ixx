@@ -0,0 +1,263 @@
+/// @file task_graph.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+export module task_graph;
+import thread_pool;
+
+namespace toast {
+
+/// @brief Dependency graph of jobs that is built once and executed many times
+/// @note Edges come from the resources each node reads and writes, in the order nodes are added.
+/// Executing does not allocate, every node becomes a job as soon as its last dependency finishes
+export class TaskGraph {
+public:
+	using NodeId = uint32_t;
+	using ResourceId = uint32_t;
+
+	/// @brief Declares something nodes can read or write, only used to derive edges
+	ResourceId CreateResource(std::string name);
+
+	/// @brief Adds a node that runs after the last writer of everything it reads or writes,
+	/// and after every reader of what it writes
+	NodeId AddNode(std::string name, const std::vector<ResourceId>& reads, const std::vector<ResourceId>& writes, std::function<void()> func);
+
+	/// @brief Extra edge not expressed through resources
+	/// @note Nodes are kept in insertion order, so before has to be added first
+	void Precede(NodeId before, NodeId after);
+
+	/// @brief Freezes the graph, has to be called before Execute
+	void Compile();
+
+	/// @brief Runs every node on the pool and returns once all of them are done
+	/// @note The calling thread helps running nodes while it waits
+	void Execute(ThreadPool& pool);
+
+	/// @brief Prints the longest chain of the last execution, weighted by measured node time
+	void DumpCriticalPath() const;
+
+	/// @brief Removes every node and resource
+	void Clear();
+
+	[[nodiscard]]
+	size_t size() const { return m_nodes.size(); }
+
+	[[nodiscard]]
+	bool empty() const { return m_nodes.empty(); }
+
+private:
+	struct Node {
+		std::string name;
+		std::function<void()> func;
+		uint32_t dependencyCount = 0;
+		uint32_t firstSuccessor = 0;
+		uint32_t successorCount = 0;
+	};
+
+	struct Resource {
+		std::string name;
+		NodeId lastWriter = NO_NODE;
+		std::vector<NodeId> readers; // since the last write
+	};
+
+	static constexpr NodeId NO_NODE = ~0u;
+
+	void AddEdge(NodeId before, NodeId after);
+	void RunNode(TaskGroup& group, NodeId node);
+
+	std::vector<Node> m_nodes;
+	std::vector<Resource> m_resources;
+	std::vector<std::pair<NodeId, NodeId>> m_edges;
+	std::vector<NodeId> m_successors;
+	std::vector<NodeId> m_roots;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_remaining;
+	bool m_compiled = false;
+
+	// Timing of the last execution, in ns since it started
+	std::chrono::steady_clock::time_point m_executeStart;
+	std::vector<int64_t> m_startTimes;
+	std::vector<int64_t> m_endTimes;
+	int64_t m_lastExecuteTime = 0;
+};
+
+TaskGraph::ResourceId TaskGraph::CreateResource(std::string name) {
+	m_resources.push_back(Resource{ .name = std::move(name) });
+	m_compiled = false;
+	return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+TaskGraph::NodeId TaskGraph::AddNode(std::string name, const std::vector<ResourceId>& reads, const std::vector<ResourceId>& writes, std::function<void()> func) {
+	NodeId node = static_cast<NodeId>(m_nodes.size());
+	m_nodes.push_back(Node{ .name = std::move(name), .func = std::move(func) });
+	m_compiled = false;
+
+	for (ResourceId id : reads) {
+		Resource& resource = m_resources.at(id);
+		if (resource.lastWriter != NO_NODE) AddEdge(resource.lastWriter, node);
+		resource.readers.push_back(node);
+	}
+
+	for (ResourceId id : writes) {
+		Resource& resource = m_resources.at(id);
+		if (resource.lastWriter != NO_NODE) AddEdge(resource.lastWriter, node);
+		for (NodeId reader : resource.readers) {
+			if (reader != node) AddEdge(reader, node);
+		}
+		resource.readers.clear();
+		resource.lastWriter = node;
+	}
+
+	return node;
+}
+
+void TaskGraph::Precede(NodeId before, NodeId after) {
+	if (before >= after || after >= m_nodes.size()) {
+		throw std::runtime_error("TaskGraph edges must point to a node added later");
+	}
+	AddEdge(before, after);
+	m_compiled = false;
+}
+
+void TaskGraph::AddEdge(NodeId before, NodeId after) {
+	m_edges.emplace_back(before, after);
+}
+
+void TaskGraph::Compile() {
+	std::ranges::sort(m_edges);
+	auto duplicates = std::ranges::unique(m_edges);
+	m_edges.erase(duplicates.begin(), duplicates.end());
+
+	for (Node& node : m_nodes) {
+		node.dependencyCount = 0;
+		node.successorCount = 0;
+	}
+
+	// Edges are sorted by source, so successors of a node end up contiguous
+	m_successors.clear();
+	m_successors.reserve(m_edges.size());
+	for (auto [before, after] : m_edges) {
+		Node& source = m_nodes[before];
+		if (source.successorCount == 0) {
+			source.firstSuccessor = static_cast<uint32_t>(m_successors.size());
+		}
+		source.successorCount++;
+		m_nodes[after].dependencyCount++;
+		m_successors.push_back(after);
+	}
+
+	m_roots.clear();
+	for (NodeId node = 0; node < m_nodes.size(); ++node) {
+		if (m_nodes[node].dependencyCount == 0) m_roots.push_back(node);
+	}
+
+	m_remaining = std::make_unique<std::atomic<uint32_t>[]>(m_nodes.size());
+	m_startTimes.assign(m_nodes.size(), 0);
+	m_endTimes.assign(m_nodes.size(), 0);
+	m_compiled = true;
+}
+
+void TaskGraph::Execute(ThreadPool& pool) {
+	if (!m_compiled) {
+		throw std::runtime_error("TaskGraph has to be compiled before executing it");
+	}
+
+	for (NodeId node = 0; node < m_nodes.size(); ++node) {
+		m_remaining[node].store(m_nodes[node].dependencyCount, std::memory_order_relaxed);
+	}
+
+	m_executeStart = std::chrono::steady_clock::now();
+	{
+		TaskGroup group(pool);
+		for (NodeId root : m_roots) {
+			group.Run([this, &group, root] { RunNode(group, root); });
+		}
+		group.Wait();
+	}
+	m_lastExecuteTime = (std::chrono::steady_clock::now() - m_executeStart).count();
+}
+
+void TaskGraph::RunNode(TaskGroup& group, NodeId node) {
+	// Keep going with one ready successor on this thread, queue the rest
+	while (node != NO_NODE) {
+		const Node& current = m_nodes[node];
+
+		m_startTimes[node] = (std::chrono::steady_clock::now() - m_executeStart).count();
+		current.func();
+		m_endTimes[node] = (std::chrono::steady_clock::now() - m_executeStart).count();
+
+		NodeId next = NO_NODE;
+		for (uint32_t i = 0; i < current.successorCount; ++i) {
+			NodeId successor = m_successors[current.firstSuccessor + i];
+			if (m_remaining[successor].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+			if (next == NO_NODE) {
+				next = successor;
+			} else {
+				group.Run([this, &group, successor] { RunNode(group, successor); });
+			}
+		}
+		node = next;
+	}
+}
+
+void TaskGraph::DumpCriticalPath() const {
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	// Nodes are topologically sorted by construction, a single forward pass finds the heaviest chain
+	std::vector<int64_t> pathCost(m_nodes.size(), 0);
+	std::vector<NodeId> previous(m_nodes.size(), NO_NODE);
+	NodeId last = 0;
+	for (NodeId node = 0; node < m_nodes.size(); ++node) {
+		pathCost[node] += m_endTimes[node] - m_startTimes[node];
+		if (pathCost[node] > pathCost[last]) last = node;
+
+		const Node& current = m_nodes[node];
+		for (uint32_t i = 0; i < current.successorCount; ++i) {
+			NodeId successor = m_successors[current.firstSuccessor + i];
+			if (pathCost[node] > pathCost[successor]) {
+				pathCost[successor] = pathCost[node];
+				previous[successor] = node;
+			}
+		}
+	}
+
+	std::vector<NodeId> path;
+	for (NodeId node = last; node != NO_NODE; node = previous[node]) {
+		path.push_back(node);
+	}
+
+	std::println("Task graph: {} nodes, {:.3f} ms wall, critical path {:.3f} ms over {} nodes:",
+		m_nodes.size(), m_lastExecuteTime / 1e6, pathCost[last] / 1e6, path.size());
+	for (auto it = path.rbegin(); it != path.rend(); ++it) {
+		std::println("\t{:<24} start {:8.3f} ms  took {:8.3f} ms", m_nodes[*it].name,
+			m_startTimes[*it] / 1e6, (m_endTimes[*it] - m_startTimes[*it]) / 1e6);
+	}
+}
+
+void TaskGraph::Clear() {
+	m_nodes.clear();
+	m_resources.clear();
+	m_edges.clear();
+	m_successors.clear();
+	m_roots.clear();
+	m_remaining.reset();
+	m_compiled = false;
+}
+
+}
@@ -4,26 +4,257 @@
 
 module;
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
-#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <print>
-#include <queue>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 export module thread_pool;
 
 namespace toast {
 
+/// @brief How queued jobs are distributed between workers
+export enum class SchedulerMode {
+	eSharedQueue,  ///< Every job goes through one lock-free bounded MPMC ring that all workers take from
+	eWorkStealing  ///< Per-worker lock-free deques, idle workers steal from random victims
+};
+
+/// @brief Chase-Lev deque. The owning worker pushes and pops at the bottom,
+/// any other thread may steal from the top
+/// @note Fixed capacity, Push returns false when full so the caller can fall back to the shared queue
+export template<typename T>
+class WorkStealingDeque {
+public:
+	static constexpr int64_t CAPACITY = 4096;
+
+	/// @brief Owner only
+	bool Push(T item) {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= CAPACITY) {
+			return false;
+		}
+		m_items[bottom & MASK].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// @brief Owner only
+	std::optional<T> Pop() {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom) {
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+
+		T item = m_items[bottom & MASK].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// Last item, race against thieves for it
+			bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			if (!won) {
+				return std::nullopt;
+			}
+		}
+		return item;
+	}
+
+	/// @brief Any thread
+	std::optional<T> Steal() {
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if (top >= bottom) {
+			return std::nullopt;
+		}
+
+		T item = m_items[top & MASK].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return std::nullopt;
+		}
+		return item;
+	}
+
+private:
+	static constexpr int64_t MASK = CAPACITY - 1;
+	static_assert((CAPACITY & MASK) == 0, "Deque capacity must be a power of two");
+
+	alignas(64) std::atomic<int64_t> m_top{0};
+	alignas(64) std::atomic<int64_t> m_bottom{0};
+	std::array<std::atomic<T>, CAPACITY> m_items{};
+};
+
+/// @brief Move-only callable with fixed inline storage, queuing one never allocates
+/// @note Captures that do not fit are rejected at compile time, capture big state by reference or pointer instead
+export class Job {
+public:
+	static constexpr size_t STORAGE_SIZE = 64;
+
+	Job() = default;
+
+	template<typename Func>
+		requires (!std::is_same_v<std::remove_cvref_t<Func>, Job> && std::is_invocable_v<std::remove_cvref_t<Func>&>)
+	Job(Func&& func) {
+		using Callable = std::remove_cvref_t<Func>;
+		static_assert(sizeof(Callable) <= STORAGE_SIZE, "Job capture does not fit in the inline storage");
+		static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job capture is over-aligned");
+		static_assert(std::is_nothrow_move_constructible_v<Callable>, "Job capture must be nothrow movable");
+
+		::new (static_cast<void*>(m_storage)) Callable(std::forward<Func>(func));
+		m_ops = &OPS<Callable>;
+	}
+
+	Job(Job&& other) noexcept { MoveFrom(other); }
+
+	Job& operator=(Job&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	Job(const Job&) = delete;
+	Job& operator=(const Job&) = delete;
+
+	~Job() { Reset(); }
+
+	void operator()() { m_ops->invoke(m_storage); }
+
+	explicit operator bool() const { return m_ops != nullptr; }
+
+	void Reset() {
+		if (m_ops) {
+			m_ops->destroy(m_storage);
+			m_ops = nullptr;
+		}
+	}
+
+private:
+	struct Ops {
+		void (*invoke)(void* storage);
+		void (*relocate)(void* dst, void* src);
+		void (*destroy)(void* storage);
+	};
+
+	template<typename Callable>
+	static constexpr Ops OPS = {
+		.invoke = [](void* storage) { (*static_cast<Callable*>(storage))(); },
+		.relocate = [](void* dst, void* src) {
+			::new (dst) Callable(std::move(*static_cast<Callable*>(src)));
+			static_cast<Callable*>(src)->~Callable();
+		},
+		.destroy = [](void* storage) { static_cast<Callable*>(storage)->~Callable(); }
+	};
+
+	void MoveFrom(Job& other) {
+		if (other.m_ops) {
+			other.m_ops->relocate(m_storage, other.m_storage);
+			m_ops = std::exchange(other.m_ops, nullptr);
+		}
+	}
+
+	alignas(std::max_align_t) std::byte m_storage[STORAGE_SIZE];
+	const Ops* m_ops = nullptr;
+};
+
+/// @brief Lock-free bounded multi-producer multi-consumer ring (Vyukov)
+/// @note Capacity is fixed at construction, Push returns false when full
+template<typename T>
+class BoundedQueue {
+public:
+	/// @brief (Re)allocates the ring, capacity must be a power of two. Not thread safe
+	void Reset(size_t capacity) {
+		m_cells = capacity > 0 ? std::make_unique<Cell[]>(capacity) : nullptr;
+		m_mask = capacity - 1;
+		m_enqueuePos = 0;
+		m_dequeuePos = 0;
+		for (size_t i = 0; i < capacity; ++i) {
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool Push(T value) {
+		Cell* cell = nullptr;
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &m_cells[pos & m_mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->value = value;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T& value) {
+		Cell* cell = nullptr;
+		size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &m_cells[pos & m_mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+			if (diff == 0) {
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		value = cell->value;
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> m_cells;
+	size_t m_mask = 0;
+	alignas(64) std::atomic<size_t> m_enqueuePos = 0;
+	alignas(64) std::atomic<size_t> m_dequeuePos = 0;
+};
+
+export class TaskGroup;
+
 export class ThreadPool {
 public:
 	/// @brief Initializes the thread pool
 	/// @param size Number of workers to create
-	void Init(size_t size);
+	/// @param mode Scheduling strategy for queued jobs
+	void Init(size_t size, SchedulerMode mode = SchedulerMode::eWorkStealing);
 
 	/// @brief Adds a job to the queue to be picked by a worker
-	void QueueJob(std::function<void()>&& job);
+	/// @note Called from a worker in work-stealing mode the job goes to that worker's own deque.
+	/// If every preallocated job slot is taken the job runs right away on the calling thread
+	void QueueJob(Job&& job);
 
 	/// @brief Ends the thread pool
 	void Destroy();
@@ -31,35 +262,179 @@ public:
 	[[nodiscard]]
 	bool busy();
 
+	/// @brief Runs func(begin, end) over [0, count) split into chunks of grainSize, blocking until every chunk is done
+	/// @note The calling thread runs the first chunk and then helps with queued jobs while it waits
+	template<typename Func>
+	void ParallelFor(size_t count, size_t grainSize, Func&& func);
+
+	/// @brief Takes one queued job, if there is any, and runs it on the calling thread
+	bool RunPendingJob();
+
+	[[nodiscard]]
+	size_t size() const { return m_workers.size(); }
+
+	[[nodiscard]]
+	SchedulerMode mode() const { return m_mode; }
+
 private:
-	void ThreadLoop();
+	friend class TaskGroup;
+
+	/// Jobs live in a preallocated slot array, queues only pass slot indices around
+	static constexpr uint32_t JOB_CAPACITY = 1u << 14;
+
+	struct Worker {
+		WorkStealingDeque<uint32_t> deque;
+		uint32_t rng = 0;
+	};
+
+	void ThreadLoop(size_t workerIndex);
+	bool TakeJob(size_t workerIndex, uint32_t& slot);
+	bool TakeSharedJob(uint32_t& slot);
+	bool StealJob(uint32_t& rng, size_t skipIndex, uint32_t& slot);
+	void RunSlot(uint32_t slot);
+	void WakeWorker();
 
-	bool m_shouldStop = false;
+	/// @brief Parks the calling thread until counter reaches zero or new jobs show up
+	void Park(const std::atomic<uint32_t>& counter);
+	void NotifyGroupDone();
+
+	SchedulerMode m_mode = SchedulerMode::eWorkStealing;
+	std::atomic<bool> m_shouldStop = false;
 	std::mutex m_queueMutex;
 	std::condition_variable m_conditionMutex;
 	std::vector<std::thread> m_workers;
-	std::queue<std::function<void()>> m_jobs;
+	std::vector<std::unique_ptr<Worker>> m_workerData;
+
+	std::unique_ptr<Job[]> m_jobSlots;
+	BoundedQueue<uint32_t> m_freeSlots;
+	BoundedQueue<uint32_t> m_jobs;
+
+	/// Jobs queued but not yet picked, over every queue. Can go briefly negative when a job
+	/// is stolen before its push is counted
+	std::atomic<int64_t> m_pendingJobs = 0;
+	std::atomic<uint32_t> m_sleepingWorkers = 0;
 };
 
-void ThreadPool::Init(size_t size) {
+/// @brief Set of jobs that can be waited on together (fork-join)
+export class TaskGroup {
+public:
+	explicit TaskGroup(ThreadPool& pool) : m_pool(pool) {}
+	~TaskGroup() { Wait(); }
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/// @brief Queues a job that belongs to this group
+	template<typename Func>
+	void Run(Func&& func) {
+		m_pending.fetch_add(1, std::memory_order_relaxed);
+		m_pool.QueueJob(Job([this, func = std::forward<Func>(func)]() mutable {
+			func();
+			Finish();
+		}));
+	}
+
+	/// @brief Runs queued jobs on the calling thread until the group is done, parking when there is nothing to run
+	void Wait();
+
+private:
+	void Finish();
+
+	ThreadPool& m_pool;
+	std::atomic<uint32_t> m_pending = 0;
+};
+
+/// Pool and index of the worker running on this thread, if any
+thread_local ThreadPool* t_currentPool = nullptr;
+thread_local size_t t_workerIndex = 0;
+/// Victim picker for threads outside the pool helping from TaskGroup::Wait
+thread_local uint32_t t_helperRng = 0x9E3779B9u;
+
+template<typename Func>
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, Func&& func) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	TaskGroup group(*this);
+	for (size_t begin = grainSize; begin < count; begin += grainSize) {
+		size_t end = std::min(begin + grainSize, count);
+		group.Run([&func, begin, end] {
+			func(begin, end);
+		});
+	}
+
+	func(size_t{0}, std::min(grainSize, count));
+	group.Wait();
+}
+
+void TaskGroup::Wait() {
+	while (m_pending.load(std::memory_order_acquire) != 0) {
+		if (!m_pool.RunPendingJob()) {
+			m_pool.Park(m_pending);
+		}
+	}
+}
+
+void TaskGroup::Finish() {
+	// The group may be destroyed as soon as the counter hits zero, only touch the pool after that
+	ThreadPool& pool = m_pool;
+	if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		pool.NotifyGroupDone();
+	}
+}
+
+void ThreadPool::Init(size_t size, SchedulerMode mode) {
 	const size_t max_thread_num = std::thread::hardware_concurrency();
 	if (size == 0) {
 		size = max_thread_num;
 	}
 	size_t target_thread_num = std::min(size, max_thread_num);
+
+	m_mode = mode;
+	m_shouldStop = false;
+
+	m_jobSlots = std::make_unique<Job[]>(JOB_CAPACITY);
+	m_freeSlots.Reset(JOB_CAPACITY);
+	m_jobs.Reset(JOB_CAPACITY);
+	for (uint32_t slot = 0; slot < JOB_CAPACITY; ++slot) {
+		[[maybe_unused]] bool pushed = m_freeSlots.Push(slot);
+	}
+
+	m_workerData.reserve(target_thread_num);
 	for (size_t i = 0; i < target_thread_num; ++i) {
-		m_workers.emplace_back(&ThreadPool::ThreadLoop, this);
+		auto worker = std::make_unique<Worker>();
+		worker->rng = static_cast<uint32_t>(i * 2654435761u) | 1u;
+		m_workerData.push_back(std::move(worker));
+	}
+	// Deques have to exist before any worker can try to steal from them
+	for (size_t i = 0; i < target_thread_num; ++i) {
+		m_workers.emplace_back(&ThreadPool::ThreadLoop, this, i);
 	}
 
-	std::println("Created thread pool with {0} workers", target_thread_num);
+	std::println("Created thread pool with {0} workers ({1})", target_thread_num,
+		m_mode == SchedulerMode::eWorkStealing ? "work-stealing" : "shared queue");
 }
 
-void ThreadPool::QueueJob(std::function<void()>&& job) {
-	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		m_jobs.emplace(job);
+void ThreadPool::QueueJob(Job&& job) {
+	uint32_t slot;
+	if (!m_freeSlots.Pop(slot)) {
+		job();
+		return;
 	}
-	m_conditionMutex.notify_one();
+	m_jobSlots[slot] = std::move(job);
+
+	if (m_mode == SchedulerMode::eWorkStealing && t_currentPool == this && m_workerData[t_workerIndex]->deque.Push(slot)) {
+		m_pendingJobs.fetch_add(1);
+		WakeWorker();
+		return;
+	}
+
+	// Outside the pool, shared mode or own deque full. Never fails, it has room for every slot
+	[[maybe_unused]] bool pushed = m_jobs.Push(slot);
+	m_pendingJobs.fetch_add(1);
+	WakeWorker();
 }
 
 void ThreadPool::Destroy() {
@@ -75,36 +450,136 @@ void ThreadPool::Destroy() {
 
 	m_workers.clear();
 
+	// Drop whatever was never picked up
+	m_workerData.clear();
+	m_jobSlots.reset();
+	m_freeSlots.Reset(0);
+	m_jobs.Reset(0);
+	m_pendingJobs = 0;
+
 	std::println("Destroyed thread pool");
 }
 
 bool ThreadPool::busy() {
-	bool pool_busy = false;
+	return m_pendingJobs.load() > 0;
+}
+
+void ThreadPool::WakeWorker() {
+	if (m_sleepingWorkers.load() == 0) {
+		return;
+	}
+
+	// Taking the lock orders this wake after a worker that is about to sleep has checked its predicate
 	{
-		std::unique_lock<std::mutex> lock(m_queueMutex);
-		pool_busy = !m_jobs.empty();
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+	}
+	m_conditionMutex.notify_one();
+}
+
+bool ThreadPool::RunPendingJob() {
+	uint32_t slot;
+	if (t_currentPool == this) {
+		if (!TakeJob(t_workerIndex, slot)) {
+			return false;
+		}
+	} else if (!(m_mode == SchedulerMode::eWorkStealing && StealJob(t_helperRng, m_workerData.size(), slot)) && !TakeSharedJob(slot)) {
+		return false;
+	}
+
+	RunSlot(slot);
+	return true;
+}
+
+void ThreadPool::RunSlot(uint32_t slot) {
+	// Move the job out first so its slot can be reused while it runs
+	Job job = std::move(m_jobSlots[slot]);
+	[[maybe_unused]] bool pushed = m_freeSlots.Push(slot);
+	job();
+}
+
+void ThreadPool::Park(const std::atomic<uint32_t>& counter) {
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	m_sleepingWorkers.fetch_add(1);
+	m_conditionMutex.wait(lock, [this, &counter] {
+		return counter.load() == 0 || m_pendingJobs.load() > 0 || m_shouldStop;
+	});
+	m_sleepingWorkers.fetch_sub(1);
+}
+
+void ThreadPool::NotifyGroupDone() {
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+	}
+	m_conditionMutex.notify_all();
+}
+
+bool ThreadPool::TakeSharedJob(uint32_t& slot) {
+	if (!m_jobs.Pop(slot)) {
+		return false;
+	}
+	m_pendingJobs.fetch_sub(1);
+	return true;
+}
+
+bool ThreadPool::TakeJob(size_t workerIndex, uint32_t& slot) {
+	if (m_mode == SchedulerMode::eSharedQueue) {
+		return TakeSharedJob(slot);
 	}
-	return pool_busy;
+
+	if (auto own_slot = m_workerData[workerIndex]->deque.Pop()) {
+		m_pendingJobs.fetch_sub(1);
+		slot = *own_slot;
+		return true;
+	}
+
+	return StealJob(m_workerData[workerIndex]->rng, workerIndex, slot) || TakeSharedJob(slot);
 }
 
-void ThreadPool::ThreadLoop() {
-	while (true) {
-		std::function<void()> job;
+bool ThreadPool::StealJob(uint32_t& rng, size_t skipIndex, uint32_t& slot) {
+	const size_t worker_count = m_workerData.size();
+	if (worker_count == 0) {
+		return false;
+	}
+
+	// Try a random victim and walk the rest from there
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
 
-		{
+	const size_t first_victim = rng % worker_count;
+	for (size_t i = 0; i < worker_count; ++i) {
+		size_t victim = (first_victim + i) % worker_count;
+		if (victim == skipIndex) continue;
+		if (auto stolen_slot = m_workerData[victim]->deque.Steal()) {
+			m_pendingJobs.fetch_sub(1);
+			slot = *stolen_slot;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::ThreadLoop(size_t workerIndex) {
+	t_currentPool = this;
+	t_workerIndex = workerIndex;
+
+	while (!m_shouldStop) {
+		uint32_t slot;
+
+		if (!TakeJob(workerIndex, slot)) {
 			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_sleepingWorkers.fetch_add(1);
 			m_conditionMutex.wait(lock, [this] {
-				return !m_jobs.empty() || m_shouldStop;
+				return m_pendingJobs.load() > 0 || m_shouldStop;
 			});
-			if (m_shouldStop) {
-				return;
-			}
-			job = m_jobs.front();
-			m_jobs.pop();
+			m_sleepingWorkers.fetch_sub(1);
+			continue;
 		}
 
-		job();
+		RunSlot(slot);
 	}
+
+	t_currentPool = nullptr;
 }
 
 }
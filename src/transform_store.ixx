@@ -0,0 +1,227 @@
+/// @file transform_store.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define TOAST_TRANSFORMS_SSE 1
+#endif
+
+export module transform_store;
+
+namespace toast {
+
+/// @brief Second destination of TransformStore::WriteWorldMatrices, e.g. a mapped GPU buffer
+export struct MatrixMirror {
+	static constexpr uint32_t NO_SLOT = ~0u;
+
+	std::byte* base = nullptr;       ///< Nothing is mirrored when null
+	size_t stride = sizeof(glm::mat4);
+	const uint32_t* slots = nullptr; ///< Slot of every index, NO_SLOT for the ones that are not mirrored
+};
+
+/// @brief Position, rotation and scale of many objects as structure of arrays
+/// @note Matrices are built four objects at a time, one object per SIMD lane
+export class TransformStore {
+public:
+	/// @brief Resizes the store, new entries are identity transforms
+	void Resize(size_t count);
+
+	void SetPosition(size_t index, const glm::vec3& position);
+	/// @param rotation Has to be normalized
+	void SetRotation(size_t index, const glm::quat& rotation);
+	void SetScale(size_t index, const glm::vec3& scale);
+
+	[[nodiscard]]
+	glm::vec3 position(size_t index) const { return { m_positionX[index], m_positionY[index], m_positionZ[index] }; }
+
+	[[nodiscard]]
+	size_t size() const { return m_positionX.size(); }
+
+	/// @brief Parent of a root in WriteWorldMatrices
+	static constexpr uint32_t NO_PARENT = ~0u;
+
+	/// @brief world[i] = world[parents[i]] * local matrix of i for every i in indices, roots take their local matrix
+	/// @note Parents are read from world while it is written, so no index may be the parent of another one in the
+	/// same call, e.g. call once per hierarchy level. Indices with a mirror slot are written to the mirror too
+	void WriteWorldMatrices(std::span<const uint32_t> indices, const uint32_t* parents, glm::mat4* world, const MatrixMirror& mirror = {}) const;
+
+private:
+	[[nodiscard]]
+	glm::mat4 LocalMatrix(uint32_t index) const;
+
+#ifdef TOAST_TRANSFORMS_SSE
+	/// @brief Element [column][row] of the local matrices of four indices, one index per lane
+	void LocalColumns(const uint32_t (&lanes)[4], __m128 (&columns)[4][4]) const;
+#endif
+
+	std::vector<float> m_positionX, m_positionY, m_positionZ;
+	std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+	std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+};
+
+void TransformStore::Resize(size_t count) {
+	m_positionX.resize(count, 0.0f);
+	m_positionY.resize(count, 0.0f);
+	m_positionZ.resize(count, 0.0f);
+	m_rotationX.resize(count, 0.0f);
+	m_rotationY.resize(count, 0.0f);
+	m_rotationZ.resize(count, 0.0f);
+	m_rotationW.resize(count, 1.0f);
+	m_scaleX.resize(count, 1.0f);
+	m_scaleY.resize(count, 1.0f);
+	m_scaleZ.resize(count, 1.0f);
+}
+
+void TransformStore::SetPosition(size_t index, const glm::vec3& position) {
+	m_positionX[index] = position.x;
+	m_positionY[index] = position.y;
+	m_positionZ[index] = position.z;
+}
+
+void TransformStore::SetRotation(size_t index, const glm::quat& rotation) {
+	m_rotationX[index] = rotation.x;
+	m_rotationY[index] = rotation.y;
+	m_rotationZ[index] = rotation.z;
+	m_rotationW[index] = rotation.w;
+}
+
+void TransformStore::SetScale(size_t index, const glm::vec3& scale) {
+	m_scaleX[index] = scale.x;
+	m_scaleY[index] = scale.y;
+	m_scaleZ[index] = scale.z;
+}
+
+void TransformStore::WriteWorldMatrices(std::span<const uint32_t> indices, const uint32_t* parents, glm::mat4* world, const MatrixMirror& mirror) const {
+	static const glm::mat4 IDENTITY(1.0f);
+	auto parentOf = [&](uint32_t index) -> const float* {
+		return parents[index] == NO_PARENT ? &IDENTITY[0][0] : &world[parents[index]][0][0];
+	};
+	auto mirrorOf = [&](uint32_t index) -> float* {
+		if (!mirror.base || mirror.slots[index] == MatrixMirror::NO_SLOT) return nullptr;
+		return reinterpret_cast<float*>(mirror.base + mirror.slots[index] * mirror.stride);
+	};
+
+	size_t k = 0;
+
+#ifdef TOAST_TRANSFORMS_SSE
+	for (; k + 4 <= indices.size(); k += 4) {
+		uint32_t lanes[4] = { indices[k], indices[k + 1], indices[k + 2], indices[k + 3] };
+		__m128 local[4][4];
+		LocalColumns(lanes, local);
+
+		// Parents transposed into the same [column][row] layout, four matrices per register
+		const float* parentMatrices[4] = { parentOf(lanes[0]), parentOf(lanes[1]), parentOf(lanes[2]), parentOf(lanes[3]) };
+		__m128 parent[4][4];
+		for (int column = 0; column < 4; ++column) {
+			__m128* rows = parent[column];
+			for (int lane = 0; lane < 4; ++lane) {
+				rows[lane] = _mm_loadu_ps(parentMatrices[lane] + column * 4);
+			}
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+		}
+
+		// result[c][r] = sum over j of parent[j][r] * local[c][j], all four matrices at once
+		__m128 result[4][4];
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				result[column][row] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(parent[0][row], local[column][0]), _mm_mul_ps(parent[1][row], local[column][1])),
+					_mm_add_ps(_mm_mul_ps(parent[2][row], local[column][2]), _mm_mul_ps(parent[3][row], local[column][3])));
+			}
+			__m128* rows = result[column];
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+		}
+
+		// One whole matrix after the other, so the mirror sees every entry as one contiguous 64 byte write
+		for (int lane = 0; lane < 4; ++lane) {
+			float* dst = &world[lanes[lane]][0][0];
+			for (int column = 0; column < 4; ++column) {
+				_mm_storeu_ps(dst + column * 4, result[column][lane]);
+			}
+			if (float* mirrored = mirrorOf(lanes[lane])) {
+				for (int column = 0; column < 4; ++column) {
+					_mm_storeu_ps(mirrored + column * 4, result[column][lane]);
+				}
+			}
+		}
+	}
+#endif
+
+	for (; k < indices.size(); ++k) {
+		uint32_t index = indices[k];
+		glm::mat4 local = LocalMatrix(index);
+		world[index] = parents[index] == NO_PARENT ? local : world[parents[index]] * local;
+		if (float* mirrored = mirrorOf(index)) {
+			std::memcpy(mirrored, &world[index], sizeof(glm::mat4));
+		}
+	}
+}
+
+// Both paths build translate * mat4_cast(rotation) * scale, columns laid out like glm::mat4
+glm::mat4 TransformStore::LocalMatrix(uint32_t i) const {
+	float qx = m_rotationX[i], qy = m_rotationY[i], qz = m_rotationZ[i], qw = m_rotationW[i];
+	float sx = m_scaleX[i], sy = m_scaleY[i], sz = m_scaleZ[i];
+
+	float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+	float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+	float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+	return glm::mat4(
+		(1.0f - 2.0f * (yy + zz)) * sx, 2.0f * (xy + wz) * sx, 2.0f * (xz - wy) * sx, 0.0f,
+		2.0f * (xy - wz) * sy, (1.0f - 2.0f * (xx + zz)) * sy, 2.0f * (yz + wx) * sy, 0.0f,
+		2.0f * (xz + wy) * sz, 2.0f * (yz - wx) * sz, (1.0f - 2.0f * (xx + yy)) * sz, 0.0f,
+		m_positionX[i], m_positionY[i], m_positionZ[i], 1.0f
+	);
+}
+
+#ifdef TOAST_TRANSFORMS_SSE
+void TransformStore::LocalColumns(const uint32_t (&lanes)[4], __m128 (&columns)[4][4]) const {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	auto gather = [&](const std::vector<float>& values) {
+		return _mm_setr_ps(values[lanes[0]], values[lanes[1]], values[lanes[2]], values[lanes[3]]);
+	};
+
+	__m128 qx = gather(m_rotationX), qy = gather(m_rotationY), qz = gather(m_rotationZ), qw = gather(m_rotationW);
+	__m128 sx = gather(m_scaleX), sy = gather(m_scaleY), sz = gather(m_scaleZ);
+
+	__m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+	__m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+	__m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+	columns[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+	columns[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+	columns[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+	columns[0][3] = zero;
+
+	columns[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+	columns[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+	columns[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+	columns[1][3] = zero;
+
+	columns[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+	columns[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+	columns[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+	columns[2][3] = zero;
+
+	columns[3][0] = gather(m_positionX);
+	columns[3][1] = gather(m_positionY);
+	columns[3][2] = gather(m_positionZ);
+	columns[3][3] = one;
+}
+#endif
+
+}
@@ -0,0 +1,201 @@
+/// @file upload_manager.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <print>
+#include <stdexcept>
+#include <vulkan/vulkan_raii.hpp>
+
+module vulkan.upload;
+import vulkan.device;
+import vulkan.buffers;
+import vulkan.staging;
+import vulkan.commandpool;
+import vulkan.commandbuffer;
+
+namespace vulkan {
+
+UploadManager::UploadManager(vk::DeviceSize stagingSize)
+	: m_ring(stagingSize)
+	, m_pool(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, Device::transferIndex())
+{
+	if (m_thisUploadManager) {
+		throw std::runtime_error("One Upload Manager already exists");
+	}
+	m_thisUploadManager = this;
+
+	vk::SemaphoreTypeCreateInfo timelineInfo{
+		.semaphoreType = vk::SemaphoreType::eTimeline,
+		.initialValue = 0
+	};
+	m_timeline = vk::raii::Semaphore(Device::get(), vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
+
+	// Power of two, so the ring size stays a multiple of it
+	m_copyAlignment = std::max<vk::DeviceSize>(m_copyAlignment, Device::physicalDevice().getProperties().limits.optimalBufferCopyOffsetAlignment);
+
+	std::println("Created Upload Manager on queue family {}", Device::transferIndex());
+}
+
+UploadManager::~UploadManager() {
+	Wait(Flush());
+	m_inFlight.clear();
+	m_thisUploadManager = nullptr;
+}
+
+UploadManager* UploadManager::uploadManager() {
+	if (!m_thisUploadManager) {
+		throw std::runtime_error("Trying to access Upload Manager but it doesn't exist yet");
+	}
+	return m_thisUploadManager;
+}
+
+void UploadManager::BeginBatch() {
+	RetireCompleted();
+
+	if (m_freeCommandBuffers.empty()) {
+		m_commandBuffers.push_back(m_pool.AllocateBuffer());
+		m_freeCommandBuffers.push_back(&m_commandBuffers.back());
+	}
+
+	m_openBatch = Batch{
+		.commandBuffer = m_freeCommandBuffers.back(),
+		.ticket = m_lastSubmitted + 1
+	};
+	m_freeCommandBuffers.pop_back();
+
+	m_openBatch->commandBuffer->get().begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+}
+
+std::optional<StagingAllocation> UploadManager::AllocateStaging(vk::DeviceSize size) {
+	std::optional<StagingAllocation> staging = m_ring.Allocate(size, m_copyAlignment);
+
+	// Ring is full, submit what is staged and wait for the oldest batch to give its space back
+	while (!staging && size <= m_ring.capacity()) {
+		if (m_ring.hasPending()) {
+			FlushLocked();
+		}
+		if (m_inFlight.empty()) {
+			break;
+		}
+		WaitForTimeline(m_inFlight.front().ticket);
+		RetireCompleted();
+		staging = m_ring.Allocate(size, m_copyAlignment);
+	}
+	return staging;
+}
+
+UploadTicket UploadManager::Upload(vk::Buffer dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Staging first, making room may flush the open batch
+	std::optional<StagingAllocation> staging = AllocateStaging(size);
+	if (!m_openBatch) {
+		BeginBatch();
+	}
+
+	if (staging) {
+		memcpy(staging->data, data, size);
+		m_openBatch->commandBuffer->get().copyBuffer(staging->buffer, dst, vk::BufferCopy(staging->offset, dstOffset, size));
+	} else {
+		Buffer dedicated(
+			size,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		);
+		memcpy(dedicated.Map(), data, size);
+
+		m_openBatch->commandBuffer->get().copyBuffer(*dedicated.getBuffer(), dst, vk::BufferCopy(0, dstOffset, size));
+		m_openBatch->staging.push_back(std::move(dedicated));
+	}
+	m_openBatch->bytes += size;
+
+	// Half the ring keeps the next batch staging while this one is in flight
+	UploadTicket ticket = m_openBatch->ticket;
+	if (m_openBatch->bytes >= m_ring.capacity() / 2) {
+		FlushLocked();
+	}
+	return ticket;
+}
+
+UploadTicket UploadManager::Flush() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return FlushLocked();
+}
+
+UploadTicket UploadManager::FlushLocked() {
+	if (!m_openBatch) {
+		return m_lastSubmitted;
+	}
+
+	Batch batch = std::move(*m_openBatch);
+	m_openBatch.reset();
+	batch.commandBuffer->get().end();
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{
+		.signalSemaphoreValueCount = 1,
+		.pSignalSemaphoreValues = &batch.ticket
+	};
+	vk::CommandBuffer cmdBuffer = *batch.commandBuffer->get();
+	vk::Semaphore timeline = *m_timeline;
+	vk::SubmitInfo submitInfo{
+		.pNext = &timelineInfo,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &cmdBuffer,
+		.signalSemaphoreCount = 1,
+		.pSignalSemaphores = &timeline
+	};
+	{
+		std::lock_guard<std::mutex> queueLock(Device::queueMutex());
+		Device::transferQueue().submit(submitInfo, nullptr);
+	}
+
+	m_ring.Retire(batch.ticket);
+	m_lastSubmitted = batch.ticket;
+	m_inFlight.push_back(std::move(batch));
+	return m_lastSubmitted;
+}
+
+bool UploadManager::IsComplete(UploadTicket ticket) const {
+	return m_timeline.getCounterValue() >= ticket;
+}
+
+void UploadManager::Wait(UploadTicket ticket) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_openBatch && ticket >= m_openBatch->ticket) {
+			FlushLocked();
+		}
+	}
+
+	WaitForTimeline(ticket);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	RetireCompleted();
+}
+
+void UploadManager::WaitForTimeline(UploadTicket ticket) const {
+	vk::Semaphore timeline = *m_timeline;
+	vk::SemaphoreWaitInfo waitInfo{
+		.semaphoreCount = 1,
+		.pSemaphores = &timeline,
+		.pValues = &ticket
+	};
+	[[maybe_unused]] auto result = Device::get().waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max());
+}
+
+void UploadManager::RetireCompleted() {
+	uint64_t completed = m_timeline.getCounterValue();
+	while (!m_inFlight.empty() && m_inFlight.front().ticket <= completed) {
+		m_freeCommandBuffers.push_back(m_inFlight.front().commandBuffer);
+		m_inFlight.pop_front();
+	}
+	m_ring.Reclaim(completed);
+}
+
+}
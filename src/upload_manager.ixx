@@ -0,0 +1,94 @@
+/// @file upload_manager.ixx
+/// @author Xein
+/// @date 16-Oct-2026
+
+module;
+
+#include <vulkan/vulkan_raii.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+export module vulkan.upload;
+import vulkan.device;
+import vulkan.buffers;
+import vulkan.staging;
+import vulkan.commandpool;
+import vulkan.commandbuffer;
+
+namespace vulkan {
+
+/// @brief Timeline value an upload completes at
+export using UploadTicket = uint64_t;
+
+/// @brief Batches buffer uploads into few submissions on the transfer queue
+/// @note Completion is tracked with a timeline semaphore, callers get a ticket instead of blocking.
+/// Data is staged through a persistently mapped ring, uploads block only when the ring is full.
+/// Uploads share the graphics queue when there is no dedicated transfer family, flush those from the render thread
+export class UploadManager {
+public:
+	explicit UploadManager(vk::DeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+	~UploadManager();
+	static UploadManager* uploadManager();
+
+	[[nodiscard]]
+	static UploadManager& get() { return *uploadManager(); }
+
+	static constexpr vk::DeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+	/// @brief Copies size bytes of data into dst at dstOffset, recorded into the open batch
+	/// @note Uploads larger than the staging ring get a dedicated staging buffer
+	/// @return Ticket of the batch the copy belongs to, it only completes after that batch is flushed
+	UploadTicket Upload(vk::Buffer dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset = 0);
+
+	/// @brief Submits the open batch, if it has anything in it
+	/// @return Ticket that completes once everything uploaded so far is on the GPU
+	UploadTicket Flush();
+
+	[[nodiscard]]
+	bool IsComplete(UploadTicket ticket) const;
+
+	/// @brief Blocks until the ticket completes, flushing first if it belongs to the open batch
+	void Wait(UploadTicket ticket);
+
+	/// @brief Semaphore signaled with each batch's ticket, GPU work reading uploads can wait on it
+	[[nodiscard]]
+	vk::Semaphore timeline() const { return *m_timeline; }
+
+	/// @brief Ticket of the last submitted batch
+	[[nodiscard]]
+	UploadTicket lastSubmitted() const { return m_lastSubmitted; }
+
+private:
+	struct Batch {
+		CommandBuffer* commandBuffer = nullptr;
+		std::vector<Buffer> staging; // oversized uploads, kept alive until the batch completes
+		vk::DeviceSize bytes = 0;
+		UploadTicket ticket = 0;
+	};
+
+	void BeginBatch();
+	UploadTicket FlushLocked();
+	void WaitForTimeline(UploadTicket ticket) const;
+	void RetireCompleted();
+	std::optional<StagingAllocation> AllocateStaging(vk::DeviceSize size);
+
+	static UploadManager* m_thisUploadManager;
+	mutable std::mutex m_mutex;
+	vk::raii::Semaphore m_timeline = nullptr;
+	StagingRing m_ring;
+	vk::DeviceSize m_copyAlignment = 16;
+	CommandPool m_pool;
+	std::vector<CommandBuffer*> m_freeCommandBuffers;
+	std::deque<CommandBuffer> m_commandBuffers;
+	std::optional<Batch> m_openBatch;
+	std::deque<Batch> m_inFlight;
+	UploadTicket m_lastSubmitted = 0;
+};
+
+UploadManager* UploadManager::m_thisUploadManager = nullptr;
+
+}
@@ -0,0 +1,178 @@
+/// @file bvh_test.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+///
+/// Checks Bvh::Cull against a linear sphere test after Build and after SetSphere + Refit, on scene sizes on both
+/// sides of the parallel build threshold. Then times build, refit and query at 500k objects
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+import thread_pool;
+import frustum_culling;
+import bvh;
+
+namespace {
+
+int g_failures = 0;
+
+constexpr float WORLD_SIZE = 200.0f;
+
+glm::vec4 RandomSphere(std::mt19937& rng) {
+	std::uniform_real_distribution<float> position(-WORLD_SIZE, WORLD_SIZE);
+	// Radii stay above zero, a point exactly on a plane may round differently through a box corner
+	std::uniform_real_distribution<float> radius(0.05f, 2.0f);
+	return glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+}
+
+/// @brief A camera somewhere in the world looking at a random point, so queries cut through the tree at every depth
+std::array<glm::vec4, 6> RandomFrustum(std::mt19937& rng) {
+	std::uniform_real_distribution<float> position(-WORLD_SIZE, WORLD_SIZE);
+	std::uniform_real_distribution<float> fov(20.0f, 90.0f);
+	glm::vec3 eye(position(rng), position(rng), position(rng));
+	glm::vec3 target(position(rng), position(rng), position(rng));
+	glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 proj = glm::perspectiveRH_ZO(glm::radians(fov(rng)), 16.0f / 9.0f, 0.1f, WORLD_SIZE);
+	return toast::ExtractFrustumPlanes(proj * view);
+}
+
+/// @brief Same test as the leaves, one sphere after the other
+std::vector<uint32_t> LinearCull(std::span<const glm::vec4> spheres, const std::array<glm::vec4, 6>& planes) {
+	std::vector<uint32_t> visible;
+	for (uint32_t i = 0; i < spheres.size(); ++i) {
+		const glm::vec4& sphere = spheres[i];
+		bool inside = true;
+		for (const glm::vec4& plane : planes) {
+			inside &= !(sphere.x * plane.x + sphere.y * plane.y + sphere.z * plane.z + plane.w < -sphere.w);
+		}
+		if (inside) {
+			visible.push_back(i);
+		}
+	}
+	return visible;
+}
+
+void CompareQueries(toast::Bvh& bvh, std::span<const glm::vec4> spheres, std::mt19937& rng, const char* stage) {
+	for (int query = 0; query < 8; ++query) {
+		auto planes = RandomFrustum(rng);
+		std::vector<uint32_t> expected = LinearCull(spheres, planes);
+		auto visible = bvh.Cull(planes);
+		if (!std::ranges::equal(visible, expected)) {
+			std::println(stderr, "FAILED: {} objects after {}: BVH found {} visible, linear test {}",
+				spheres.size(), stage, visible.size(), expected.size());
+			++g_failures;
+		}
+	}
+}
+
+void CheckScene(toast::ThreadPool& pool, size_t count, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::vector<glm::vec4> spheres(count);
+	for (glm::vec4& sphere : spheres) {
+		sphere = RandomSphere(rng);
+	}
+
+	toast::Bvh bvh;
+	bvh.Build(pool, spheres);
+	CompareQueries(bvh, spheres, rng, "build");
+
+	// Small moves keep the tree shape useful, teleports stretch nodes across the world
+	std::uniform_real_distribution<float> nudge(-3.0f, 3.0f);
+	std::uniform_int_distribution<int> percent(0, 99);
+	for (int round = 0; round < 3; ++round) {
+		for (uint32_t i = 0; i < count; ++i) {
+			int roll = percent(rng);
+			if (roll < 20) {
+				spheres[i] += glm::vec4(nudge(rng), nudge(rng), nudge(rng), 0.0f);
+			} else if (roll < 25) {
+				spheres[i] = RandomSphere(rng);
+			} else {
+				continue;
+			}
+			bvh.SetSphere(i, spheres[i]);
+		}
+		bvh.Refit();
+		CompareQueries(bvh, spheres, rng, "refit");
+	}
+}
+
+template<typename Func>
+double MeasureMs(int runs, Func&& func) {
+	auto start = std::chrono::steady_clock::now();
+	for (int run = 0; run < runs; ++run) {
+		func(run);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+void Benchmark(toast::ThreadPool& pool, size_t count) {
+	std::mt19937 rng(99);
+	std::vector<glm::vec4> spheres(count);
+	for (glm::vec4& sphere : spheres) {
+		sphere = RandomSphere(rng);
+	}
+
+	toast::Bvh bvh;
+	double buildMs = MeasureMs(5, [&](int) { bvh.Build(pool, spheres); });
+
+	// Every object moves a little, like the animated grid, then a tenth of them
+	std::uniform_real_distribution<float> nudge(-0.5f, 0.5f);
+	auto refitMs = [&](size_t step) {
+		return MeasureMs(5, [&](int) {
+			for (uint32_t i = 0; i < count; i += static_cast<uint32_t>(step)) {
+				spheres[i] += glm::vec4(nudge(rng), nudge(rng), nudge(rng), 0.0f);
+				bvh.SetSphere(i, spheres[i]);
+			}
+			bvh.Refit();
+		});
+	};
+	double refitAllMs = refitMs(1);
+	double refitTenthMs = refitMs(10);
+
+	std::vector<std::array<glm::vec4, 6>> frustums(32);
+	for (auto& planes : frustums) {
+		planes = RandomFrustum(rng);
+	}
+	bvh.ConsumeStats();
+	double queryMs = MeasureMs(static_cast<int>(frustums.size()), [&](int run) { bvh.Cull(frustums[run]); });
+	auto stats = bvh.ConsumeStats();
+	double linearMs = MeasureMs(static_cast<int>(frustums.size()), [&](int run) { LinearCull(spheres, frustums[run]); });
+
+	std::println("{} objects in {} nodes on {} threads: {:.2f} ms build, {:.2f} ms refit all, {:.2f} ms refit a tenth",
+		count, bvh.nodeCount(), pool.size() + 1, buildMs, refitAllMs, refitTenthMs);
+	std::println("  query {:.3f} ms ({:.0f} nodes, {:.0f} visible), linear sphere test {:.3f} ms",
+		queryMs, static_cast<double>(stats.nodesVisited) / stats.queries, static_cast<double>(stats.visible) / stats.queries, linearMs);
+}
+
+}
+
+int main() {
+	toast::ThreadPool pool;
+	pool.Init(0);
+
+	// Single leaf, a few levels, and past the size where subtrees are built as pool jobs
+	constexpr size_t COUNTS[] = { 1, 3, 4, 5, 17, 100, 1000, 10007, 100000 };
+	uint32_t seed = 1;
+	for (size_t count : COUNTS) {
+		CheckScene(pool, count, seed++);
+	}
+
+	Benchmark(pool, 500'000);
+	pool.Destroy();
+
+	if (g_failures != 0) {
+		std::println(stderr, "{} check(s) failed", g_failures);
+		return EXIT_FAILURE;
+	}
+	std::println("BVH queries match the linear sphere test after build and refit");
+	return EXIT_SUCCESS;
+}
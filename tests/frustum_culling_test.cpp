@@ -0,0 +1,159 @@
+/// @file frustum_culling_test.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+///
+/// Checks every culling kernel this CPU supports against the scalar reference on random spheres and on the
+/// cases SIMD gets wrong first: spheres touching a plane, NaNs, zero and infinite radii, counts that leave a
+/// partial register. Prints objects/ns per kernel on the way
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <print>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+import thread_pool;
+import frustum_culling;
+
+namespace {
+
+int g_failures = 0;
+
+constexpr std::array KERNELS = { toast::CullingKernel::eScalar, toast::CullingKernel::eSSE, toast::CullingKernel::eAVX2 };
+constexpr const char* KERNEL_NAMES[] = { "scalar", "SSE", "AVX2" };
+
+/// @brief Same camera as the app, looking down at the grid
+std::array<glm::vec4, 6> CameraPlanes() {
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 15.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 proj = glm::perspectiveRH_ZO(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	proj[1][1] *= -1;
+	return toast::ExtractFrustumPlanes(proj * view);
+}
+
+/// @brief Random spheres around the frustum with the edge cases mixed in
+std::vector<glm::vec4> MakeSpheres(size_t count, const std::array<glm::vec4, 6>& planes, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> radius(0.0f, 3.0f);
+	std::uniform_int_distribution<int> kind(0, 9);
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	std::vector<glm::vec4> spheres(count);
+	for (size_t i = 0; i < count; ++i) {
+		glm::vec3 center(position(rng), position(rng) * 0.5f, position(rng));
+		float r = radius(rng);
+		switch (kind(rng)) {
+		case 0: {
+			// Projected onto a plane, then pushed out by exactly its radius so it only just touches
+			const glm::vec4& plane = planes[i % planes.size()];
+			glm::vec3 normal(plane);
+			center -= normal * (glm::dot(normal, center) + plane.w);
+			center -= normal * r;
+			break;
+		}
+		case 1:
+			r = 0.0f;
+			break;
+		case 2:
+			center[i % 3] = nan;
+			break;
+		case 3:
+			r = nan;
+			break;
+		case 4:
+			r = i % 2 ? infinity : -infinity;
+			break;
+		case 5:
+			r = -r;
+			break;
+		default:
+			break;
+		}
+		spheres[i] = glm::vec4(center, r);
+	}
+	return spheres;
+}
+
+void CheckKernels(toast::ThreadPool& pool, size_t count, uint32_t seed) {
+	auto planes = CameraPlanes();
+	auto spheres = MakeSpheres(count, planes, seed);
+
+	toast::FrustumCuller culler;
+	culler.Resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		culler.SetSphere(i, glm::vec3(spheres[i]), spheres[i].w);
+	}
+
+	std::vector<uint32_t> reference;
+	culler.CullReference(planes, reference);
+	for (size_t k = 0; k < KERNELS.size(); ++k) {
+		if (!culler.SetKernel(KERNELS[k])) continue;
+
+		auto visible = culler.Cull(pool, planes);
+		if (!std::ranges::equal(visible, reference)) {
+			std::println(stderr, "FAILED: {} kernel found {} of {} spheres visible, the reference {} (seed {})",
+				KERNEL_NAMES[k], visible.size(), count, reference.size(), seed);
+			++g_failures;
+		}
+	}
+}
+
+void Benchmark(toast::ThreadPool& pool, size_t count) {
+	auto planes = CameraPlanes();
+	auto spheres = MakeSpheres(count, planes, 7);
+
+	toast::FrustumCuller culler;
+	culler.Resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		culler.SetSphere(i, glm::vec3(spheres[i]), spheres[i].w);
+	}
+
+	constexpr int RUNS = 20;
+	for (size_t k = 0; k < KERNELS.size(); ++k) {
+		if (!culler.SetKernel(KERNELS[k])) continue;
+
+		culler.Cull(pool, planes);
+		culler.ConsumeStats();
+		for (int run = 0; run < RUNS; ++run) {
+			culler.Cull(pool, planes);
+		}
+		auto stats = culler.ConsumeStats();
+		std::println("{:>6}: {} objects, {:.3f} ms per cull, {:.2f} objects/ns on {} threads",
+			KERNEL_NAMES[k], count, stats.time / 1e6 / RUNS,
+			static_cast<double>(stats.tested) / std::max<int64_t>(stats.time, 1), pool.size() + 1);
+	}
+}
+
+}
+
+int main() {
+	toast::ThreadPool pool;
+	pool.Init(0);
+
+	// Empty, below one register, one short of and one past a whole register or job
+	constexpr size_t COUNTS[] = { 0, 1, 3, 7, 9, 15, 4095, 4097, 8193, 100003 };
+	uint32_t seed = 1;
+	for (size_t count : COUNTS) {
+		for (int repeat = 0; repeat < 4; ++repeat) {
+			CheckKernels(pool, count, seed++);
+		}
+	}
+
+	Benchmark(pool, 1u << 20);
+	pool.Destroy();
+
+	if (g_failures != 0) {
+		std::println(stderr, "{} check(s) failed", g_failures);
+		return EXIT_FAILURE;
+	}
+	std::println("Every supported kernel matches the scalar reference");
+	return EXIT_SUCCESS;
+}
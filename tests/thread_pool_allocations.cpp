@@ -0,0 +1,98 @@
+/// @file thread_pool_allocations.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+///
+/// Replaces the global allocation functions with counting ones and checks that queuing, running and waiting
+/// on jobs does not touch the heap once the pool is up
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <print>
+
+import thread_pool;
+
+namespace {
+
+std::atomic<uint64_t> g_allocations = 0;
+
+void* CountedAlloc(std::size_t size, std::size_t alignment) {
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	size = size == 0 ? 1 : size;
+	void* ptr = alignment > alignof(std::max_align_t)
+		? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+		: std::malloc(size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size, 0); }
+void* operator new[](std::size_t size) { return CountedAlloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align) { return CountedAlloc(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return CountedAlloc(size, static_cast<std::size_t>(align)); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+
+/// @brief Roughly what a frame does: a fork-join group with captures close to the inline limit, then a ParallelFor
+void Frame(toast::ThreadPool& pool, std::atomic<uint64_t>& sink) {
+	toast::TaskGroup group(pool);
+	for (uint64_t i = 0; i < 512; ++i) {
+		uint64_t a = i, b = i * 3, c = i * 7, d = i * 11, e = i * 13;
+		group.Run([&sink, a, b, c, d, e] {
+			sink.fetch_add(a + b + c + d + e, std::memory_order_relaxed);
+		});
+	}
+	group.Wait();
+
+	pool.ParallelFor(20000, 128, [&sink](size_t begin, size_t end) {
+		sink.fetch_add(end - begin, std::memory_order_relaxed);
+	});
+}
+
+bool CheckMode(toast::SchedulerMode mode, const char* name) {
+	toast::ThreadPool pool;
+	pool.Init(0, mode);
+
+	std::atomic<uint64_t> sink = 0;
+	for (int i = 0; i < 8; ++i) {
+		Frame(pool, sink);
+	}
+
+	const uint64_t before = g_allocations.load();
+	for (int i = 0; i < 200; ++i) {
+		Frame(pool, sink);
+	}
+	const uint64_t allocations = g_allocations.load() - before;
+
+	pool.Destroy();
+
+	std::println("{}: {} heap allocations over 200 frames", name, allocations);
+	return allocations == 0;
+}
+
+}
+
+int main() {
+	bool ok = CheckMode(toast::SchedulerMode::eSharedQueue, "shared queue");
+	ok = CheckMode(toast::SchedulerMode::eWorkStealing, "work-stealing") && ok;
+
+	if (!ok) {
+		std::println(stderr, "FAILED: job hot path allocated after warm-up");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
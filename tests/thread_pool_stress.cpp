@@ -0,0 +1,307 @@
+/// @file thread_pool_stress.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+///
+/// Races thieves against the owner of a WorkStealingDeque and checks every item comes out exactly once,
+/// then measures pool throughput in jobs/sec from 1 to N workers for both scheduler modes against a mutex and
+/// std::function reference pool
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <queue>
+#include <thread>
+#include <vector>
+
+import thread_pool;
+
+namespace {
+
+int g_failures = 0;
+
+void Check(bool condition, const char* what) {
+	if (!condition) {
+		std::println(stderr, "FAILED: {}", what);
+		++g_failures;
+	}
+}
+
+uint32_t NextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/// @brief True when every item came out exactly once, one counter per item
+bool EveryItemOnce(const std::vector<std::atomic<uint32_t>>& runs) {
+	return std::ranges::all_of(runs, [](const std::atomic<uint32_t>& count) { return count.load() == 1; });
+}
+
+/// @brief The owner pushes in bursts and pops part of them back while thieves steal from the top
+/// @param maxBurst Largest burst the owner pushes before popping. Small values keep the deque hovering around
+/// empty so Pop and Steal keep fighting over the last item, CAPACITY makes it hit the full boundary
+void DequeRace(uint32_t itemCount, uint32_t maxBurst, size_t thiefCount) {
+	using Deque = toast::WorkStealingDeque<uint32_t>;
+	auto deque = std::make_unique<Deque>();
+	std::vector<std::atomic<uint32_t>> runs(itemCount);
+	std::atomic<bool> start = false;
+	std::atomic<bool> ownerDone = false;
+	std::atomic<uint64_t> stolen = 0;
+
+	std::vector<std::thread> thieves;
+	for (size_t i = 0; i < thiefCount; ++i) {
+		thieves.emplace_back([&] {
+			while (!start.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+			// The owner drains what is left before raising ownerDone, so an empty steal after it means we are done
+			while (true) {
+				bool done = ownerDone.load(std::memory_order_acquire);
+				if (auto item = deque->Steal()) {
+					runs[*item].fetch_add(1, std::memory_order_relaxed);
+					stolen.fetch_add(1, std::memory_order_relaxed);
+				} else if (done) {
+					break;
+				}
+			}
+		});
+	}
+
+	start.store(true, std::memory_order_release);
+
+	uint32_t rng = 0x2545F491u;
+	uint32_t next = 0;
+	uint64_t popped = 0;
+	while (next < itemCount) {
+		uint32_t burst = 1 + NextRandom(rng) % maxBurst;
+		for (uint32_t i = 0; i < burst && next < itemCount; ++i) {
+			if (!deque->Push(next)) {
+				break;
+			}
+			++next;
+		}
+
+		uint32_t pops = NextRandom(rng) % (burst + 1);
+		for (uint32_t i = 0; i < pops; ++i) {
+			auto item = deque->Pop();
+			if (!item) break;
+			runs[*item].fetch_add(1, std::memory_order_relaxed);
+			++popped;
+		}
+	}
+	while (auto item = deque->Pop()) {
+		runs[*item].fetch_add(1, std::memory_order_relaxed);
+		++popped;
+	}
+	ownerDone.store(true, std::memory_order_release);
+
+	for (std::thread& thief : thieves) {
+		thief.join();
+	}
+
+	std::println("deque race: {} items, burst <= {}, {} thieves, {} popped / {} stolen",
+		itemCount, maxBurst, thiefCount, popped, stolen.load());
+	Check(popped + stolen.load() == itemCount, "deque handed out a different number of items than were pushed");
+	Check(EveryItemOnce(runs), "deque item lost or handed out twice");
+}
+
+/// @brief What the pool looked like before the job slots and deques: one mutex, one condition variable and a
+/// std::queue of std::function. Waiting threads help run jobs, otherwise nested groups would deadlock it
+class ReferencePool {
+public:
+	explicit ReferencePool(size_t workerCount) {
+		for (size_t i = 0; i < workerCount; ++i) {
+			m_workers.emplace_back([this] {
+				while (true) {
+					std::function<void()> job;
+					{
+						std::unique_lock lock(m_mutex);
+						m_condition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+						if (m_jobs.empty()) return;
+						job = std::move(m_jobs.front());
+						m_jobs.pop();
+					}
+					job();
+				}
+			});
+		}
+	}
+
+	~ReferencePool() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+		for (std::thread& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	void QueueJob(std::function<void()> job) {
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.push(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+
+	bool RunPendingJob() {
+		std::function<void()> job;
+		{
+			std::lock_guard lock(m_mutex);
+			if (m_jobs.empty()) return false;
+			job = std::move(m_jobs.front());
+			m_jobs.pop();
+		}
+		job();
+		return true;
+	}
+
+	/// @brief Runs count jobs made by makeJob(i) and helps until they are all done
+	template<typename MakeJob>
+	void RunGroup(size_t count, MakeJob&& makeJob) {
+		std::atomic<size_t> remaining = count;
+		for (size_t i = 0; i < count; ++i) {
+			QueueJob([&remaining, job = makeJob(i)] {
+				job();
+				remaining.fetch_sub(1, std::memory_order_release);
+			});
+		}
+		while (remaining.load(std::memory_order_acquire) > 0) {
+			if (!RunPendingJob()) std::this_thread::yield();
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::queue<std::function<void()>> m_jobs;
+	std::vector<std::thread> m_workers;
+	bool m_stop = false;
+};
+
+// Spawners fan out in batches and wait for each, so at most SPAWNERS + SPAWNERS * BATCH_SIZE jobs are in flight.
+// That stays below the pool's 16384 job slots, past them QueueJob runs jobs inline and the round would time that
+constexpr size_t SPAWNERS = 64;
+constexpr size_t BATCH_SIZE = 128;
+constexpr size_t BATCHES = 32;
+constexpr size_t ROUND_JOBS = SPAWNERS * BATCHES * BATCH_SIZE;
+
+/// Set while a spawner is inside TaskGroup::Run, a job starting then was run inline instead of queued
+thread_local bool t_queueing = false;
+
+/// @brief Every worker-side job fans out into more jobs so work-stealing mode goes through the deques
+double PoolRound(toast::ThreadPool& pool, std::vector<std::atomic<uint32_t>>& runs, std::atomic<uint64_t>& inlineRuns) {
+	auto start = std::chrono::steady_clock::now();
+	toast::TaskGroup outer(pool);
+	for (size_t s = 0; s < SPAWNERS; ++s) {
+		outer.Run([&pool, &runs, &inlineRuns, s] {
+			for (size_t batch = 0; batch < BATCHES; ++batch) {
+				toast::TaskGroup inner(pool);
+				for (size_t i = 0; i < BATCH_SIZE; ++i) {
+					t_queueing = true;
+					inner.Run([&runs, &inlineRuns, index = (s * BATCHES + batch) * BATCH_SIZE + i] {
+						if (t_queueing) inlineRuns.fetch_add(1, std::memory_order_relaxed);
+						runs[index].fetch_add(1, std::memory_order_relaxed);
+					});
+					t_queueing = false;
+				}
+				inner.Wait();
+			}
+		});
+	}
+	outer.Wait();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(ROUND_JOBS) / elapsed;
+}
+
+/// @brief Same fan-out through the reference pool
+double ReferenceRound(ReferencePool& pool, std::vector<std::atomic<uint32_t>>& runs) {
+	auto start = std::chrono::steady_clock::now();
+	pool.RunGroup(SPAWNERS, [&pool, &runs](size_t s) {
+		return [&pool, &runs, s] {
+			for (size_t batch = 0; batch < BATCHES; ++batch) {
+				pool.RunGroup(BATCH_SIZE, [&runs, first = (s * BATCHES + batch) * BATCH_SIZE](size_t i) {
+					return [&runs, index = first + i] { runs[index].fetch_add(1, std::memory_order_relaxed); };
+				});
+			}
+		};
+	});
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(ROUND_JOBS) / elapsed;
+}
+
+/// @brief Jobs/sec of both scheduler modes and the reference pool from 1 to N workers
+void PoolScaling() {
+	const size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t workers = 1;; workers = std::min(workers * 2, maxWorkers)) {
+		std::vector<std::atomic<uint32_t>> runs(ROUND_JOBS);
+		auto resetRuns = [&] { for (auto& count : runs) count.store(0); };
+
+		double referenceRate;
+		{
+			ReferencePool reference(workers);
+			ReferenceRound(reference, runs);  // warm-up
+			resetRuns();
+			referenceRate = ReferenceRound(reference, runs);
+			Check(EveryItemOnce(runs), "reference pool job lost or run twice");
+		}
+
+		double rates[2];
+		uint64_t inlineCounts[2];
+		constexpr toast::SchedulerMode MODES[] = { toast::SchedulerMode::eSharedQueue, toast::SchedulerMode::eWorkStealing };
+		for (size_t m = 0; m < 2; ++m) {
+			toast::ThreadPool pool;
+			pool.Init(workers, MODES[m]);
+
+			std::atomic<uint64_t> inlineRuns = 0;
+			resetRuns();
+			PoolRound(pool, runs, inlineRuns);  // warm-up
+			resetRuns();
+			inlineRuns = 0;
+
+			rates[m] = PoolRound(pool, runs, inlineRuns);
+			inlineCounts[m] = inlineRuns.load();
+			Check(EveryItemOnce(runs), "pool job lost or run twice");
+			Check(!pool.busy(), "pool still reports pending jobs after every group finished");
+			Check(inlineCounts[m] == 0, "pool ran jobs inline, the round no longer fits the job slots");
+			pool.Destroy();
+		}
+
+		std::println("{:>3} workers: {:>12.0f} jobs/sec reference, {:>12.0f} shared queue ({:.2f}x), {:>12.0f} work-stealing ({:.2f}x), {} + {} inline",
+			workers, referenceRate, rates[0], rates[0] / referenceRate, rates[1], rates[1] / referenceRate, inlineCounts[0], inlineCounts[1]);
+		if (workers == maxWorkers) break;
+	}
+}
+
+}
+
+int main() {
+	const size_t thieves = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	constexpr uint32_t CAPACITY = toast::WorkStealingDeque<uint32_t>::CAPACITY;
+
+	// Around empty: Pop and Steal race for the single last item
+	DequeRace(1u << 20, 2, thieves);
+	// Indices wrap the ring a few hundred times
+	DequeRace(1u << 20, 64, thieves);
+	// Bursts up to capacity so Push hits the full boundary
+	DequeRace(1u << 20, CAPACITY, thieves);
+
+	PoolScaling();
+
+	if (g_failures != 0) {
+		std::println(stderr, "{} check(s) failed", g_failures);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
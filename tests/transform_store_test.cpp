@@ -0,0 +1,204 @@
+/// @file transform_store_test.cpp
+/// @author Xein
+/// @date 16-Oct-2026
+///
+/// Checks TransformStore::WriteWorldMatrices against glm::translate * glm::mat4_cast * glm::scale for roots and
+/// children, on counts that leave a scalar tail. Then times both per thread in matrices/sec per core
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <print>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+import transform_store;
+
+namespace {
+
+int g_failures = 0;
+
+struct Transform {
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+};
+
+std::vector<Transform> RandomTransforms(size_t count, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+	std::vector<Transform> transforms(count);
+	for (Transform& transform : transforms) {
+		transform.position = glm::vec3(position(rng), position(rng), position(rng));
+		transform.rotation = glm::normalize(glm::quat(axis(rng), axis(rng), axis(rng), axis(rng)));
+		transform.scale = glm::vec3(scale(rng), scale(rng), scale(rng));
+	}
+	return transforms;
+}
+
+toast::TransformStore MakeStore(std::span<const Transform> transforms) {
+	toast::TransformStore store;
+	store.Resize(transforms.size());
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		store.SetPosition(i, transforms[i].position);
+		store.SetRotation(i, transforms[i].rotation);
+		store.SetScale(i, transforms[i].scale);
+	}
+	return store;
+}
+
+/// @brief The path the store replaces
+glm::mat4 GlmMatrix(const Transform& transform) {
+	return glm::translate(glm::mat4(1.0f), transform.position) * glm::mat4_cast(transform.rotation) * glm::scale(glm::mat4(1.0f), transform.scale);
+}
+
+bool NearlyEqual(const glm::mat4& a, const glm::mat4& b) {
+	for (int column = 0; column < 4; ++column) {
+		for (int row = 0; row < 4; ++row) {
+			float tolerance = 1e-4f * std::max({ 1.0f, std::abs(a[column][row]), std::abs(b[column][row]) });
+			if (!(std::abs(a[column][row] - b[column][row]) <= tolerance)) return false;
+		}
+	}
+	return true;
+}
+
+/// @brief Roots in [0, count), then a level of children whose parents are spread over the roots
+void CheckHierarchy(size_t count, uint32_t seed) {
+	auto transforms = RandomTransforms(count * 2, seed);
+	toast::TransformStore store = MakeStore(transforms);
+
+	std::vector<uint32_t> parents(count * 2, toast::TransformStore::NO_PARENT);
+	for (size_t i = count; i < count * 2; ++i) {
+		parents[i] = static_cast<uint32_t>((i * 7) % count);
+	}
+	std::vector<uint32_t> roots(count), children(count);
+	std::iota(roots.begin(), roots.end(), 0u);
+	std::iota(children.begin(), children.end(), static_cast<uint32_t>(count));
+	// Reversed children gather their lanes from scattered indices
+	std::ranges::reverse(children);
+
+	// Only odd objects are mirrored, both destinations have to match
+	std::vector<uint32_t> slots(count * 2, toast::MatrixMirror::NO_SLOT);
+	for (size_t i = 1; i < count * 2; i += 2) {
+		slots[i] = static_cast<uint32_t>(i / 2);
+	}
+	std::vector<glm::mat4> mirrored(count);
+	toast::MatrixMirror mirror{ .base = reinterpret_cast<std::byte*>(mirrored.data()), .stride = sizeof(glm::mat4), .slots = slots.data() };
+
+	std::vector<glm::mat4> world(count * 2);
+	store.WriteWorldMatrices(roots, parents.data(), world.data(), mirror);
+	store.WriteWorldMatrices(children, parents.data(), world.data(), mirror);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < count * 2; ++i) {
+		glm::mat4 expected = GlmMatrix(transforms[i]);
+		if (parents[i] != toast::TransformStore::NO_PARENT) {
+			expected = GlmMatrix(transforms[parents[i]]) * expected;
+		}
+		if (!NearlyEqual(world[i], expected)) mismatches++;
+		if (slots[i] != toast::MatrixMirror::NO_SLOT && mirrored[slots[i]] != world[i]) mismatches++;
+	}
+	if (mismatches != 0) {
+		std::println(stderr, "FAILED: {} of {} world matrices differ from glm (seed {})", mismatches, count * 2, seed);
+		++g_failures;
+	}
+}
+
+/// @brief Runs work(thread) on every thread at once, returns matrices/sec per thread
+template<typename Func>
+double PerThreadRate(size_t threadCount, size_t matricesPerThread, Func&& work) {
+	std::atomic<size_t> ready = 0;
+	std::vector<double> seconds(threadCount);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&, t] {
+			ready.fetch_add(1);
+			while (ready.load() < threadCount) {
+				std::this_thread::yield();
+			}
+			auto start = std::chrono::steady_clock::now();
+			work(t);
+			seconds[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	double slowest = *std::ranges::max_element(seconds);
+	return static_cast<double>(matricesPerThread) / slowest;
+}
+
+void Benchmark(size_t matricesPerThread) {
+	constexpr int RUNS = 20;
+	const size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads)) {
+		size_t count = matricesPerThread * threadCount;
+		auto transforms = RandomTransforms(count, 11);
+		toast::TransformStore store = MakeStore(transforms);
+		std::vector<uint32_t> parents(count, toast::TransformStore::NO_PARENT);
+		std::vector<uint32_t> indices(count);
+		std::iota(indices.begin(), indices.end(), 0u);
+		std::vector<glm::mat4> world(count);
+
+		// Every thread owns one slice, like a ParallelFor range
+		auto slice = [&](size_t t) { return std::span<const uint32_t>(indices).subspan(t * matricesPerThread, matricesPerThread); };
+		double glmRate = PerThreadRate(threadCount, matricesPerThread * RUNS, [&](size_t t) {
+			for (int run = 0; run < RUNS; ++run) {
+				for (uint32_t i : slice(t)) {
+					world[i] = GlmMatrix(transforms[i]);
+				}
+			}
+		});
+		double simdRate = PerThreadRate(threadCount, matricesPerThread * RUNS, [&](size_t t) {
+			for (int run = 0; run < RUNS; ++run) {
+				store.WriteWorldMatrices(slice(t), parents.data(), world.data());
+			}
+		});
+		// Calls of three never fill a register, every matrix takes the scalar tail
+		double scalarRate = PerThreadRate(threadCount, matricesPerThread * RUNS, [&](size_t t) {
+			auto own = slice(t);
+			for (int run = 0; run < RUNS; ++run) {
+				for (size_t k = 0; k < own.size(); k += 3) {
+					store.WriteWorldMatrices(own.subspan(k, std::min<size_t>(3, own.size() - k)), parents.data(), world.data());
+				}
+			}
+		});
+
+		std::println("{:>3} threads: {:>7.1f} M matrices/s per core glm, {:>7.1f} M SIMD ({:.2f}x), {:>7.1f} M scalar tail ({:.2f}x)",
+			threadCount, glmRate / 1e6, simdRate / 1e6, simdRate / glmRate, scalarRate / 1e6, scalarRate / glmRate);
+		if (threadCount == maxThreads) break;
+	}
+}
+
+}
+
+int main() {
+	// Below one register, one short of and one past a whole register, then plenty of registers
+	constexpr size_t COUNTS[] = { 1, 3, 4, 5, 7, 8, 9, 1001, 65536 };
+	uint32_t seed = 1;
+	for (size_t count : COUNTS) {
+		CheckHierarchy(count, seed++);
+	}
+
+	Benchmark(1u << 16);
+
+	if (g_failures != 0) {
+		std::println(stderr, "{} check(s) failed", g_failures);
+		return EXIT_FAILURE;
+	}
+	std::println("World matrices match glm::translate * glm::mat4_cast * glm::scale");
+	return EXIT_SUCCESS;
+}